@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdlib.h"
+#include "stdio.h"
+#include "time.h"
+
+#include "src/dsu.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Chains longer than this are not walked by the recursive find, as they
+ * would overflow the stack.
+ */
+#define RECURSIVE_CHAIN_LIMIT (1 << 16)
+
+/**
+ * @brief Name of the path compression strategy dsu_find() was built with.
+ */
+#if FIND_MODE == FIND_RECURSIVE
+#define FIND_NAME "recursive"
+#elif FIND_MODE == FIND_SPLITTING
+#define FIND_NAME "splitting"
+#else
+#define FIND_NAME "halving"
+#endif
+
+/**
+ * @brief Disjoint set being benchmarked, the one the engines use.
+ */
+struct dsu dsu;
+
+/**
+ * @brief Sum of the roots returned by the finds, printed so that they can not be
+ * optimized away.
+ */
+long checksum = 0;
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Gets the current time of a monotonic clock.
+ *
+ * @return double time in milliseconds
+ */
+double now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+
+/* ############################### Scenarios ############################### */
+
+
+/**
+ * @brief Links the nodes into a single path without union by size and finds every
+ * node starting from the deepest one.
+ */
+void chain(int n) {
+  int i;
+  for (i = 0; i < n - 1; i++) dsu.parent[i] = i + 1;
+  for (i = 0; i < n; i++) checksum += dsu_find(&dsu, i);
+}
+
+/**
+ * @brief Builds a binomial tree by linking equal sized trees, which is the
+ * deepest tree union by size allows, and finds every node from the last one.
+ */
+void binomial(int n) {
+  int step, i;
+  for (step = 1; step < n; step *= 2) {
+    for (i = 0; i + step < n; i += 2 * step) dsu_link(&dsu, i, i + step);
+  }
+  for (i = n - 1; i >= 0; i--) checksum += dsu_find(&dsu, i);
+}
+
+/**
+ * @brief Random unions by size interleaved with random finds, as kruskal() does.
+ */
+void random_unions(int n) {
+  int i;
+  srand(42);
+  for (i = 0; i < 4 * n; i++) {
+    int x = dsu_find(&dsu, rand() % n), y = dsu_find(&dsu, rand() % n);
+    if (x != y) dsu_link(&dsu, x, y);
+  }
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+/**
+ * @brief Runs dsu_find(), with the strategy chosen by FIND_MODE at build time,
+ * against every scenario and prints the time each one took. make bench_find builds
+ * and runs it once per strategy.
+ *
+ * @param argc number of arguments
+ * @param argv optional number of nodes (2^20 by default)
+ *
+ * @return int 0 for success or 1 for error
+ */
+int main(int argc, char *argv[]) {
+  const char *scenario_names[] = {"chain", "binomial", "random"};
+  void (*scenarios[])(int) = {chain, binomial, random_unions};
+  int n = argc > 1 ? atoi(argv[1]) : 1 << 20, s;
+
+  if (n < 1 || dsu_init(&dsu, n) != 0) {
+    fprintf(stderr, "usage: %s [n_nodes]\n", argv[0]);
+    return 1;
+  }
+
+  for (s = 0; s < 3; s++) {
+    double start;
+
+    if (FIND_MODE == FIND_RECURSIVE && scenarios[s] == chain && n > RECURSIVE_CHAIN_LIMIT) {
+      printf("%-10s %-10s %10s\n", scenario_names[s], FIND_NAME, "overflow");
+      continue;
+    }
+
+    dsu_init(&dsu, n);
+    start = now_ms();
+    scenarios[s](n);
+    printf("%-10s %-10s %10.2f\n", scenario_names[s], FIND_NAME, now_ms() - start);
+  }
+
+  fprintf(stderr, "checksum %ld\n", checksum);
+  dsu_free(&dsu);
+  return 0;
+}
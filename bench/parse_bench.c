@@ -0,0 +1,147 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdlib.h"
+#include "stdio.h"
+#include "string.h"
+#include "time.h"
+
+#include "src/plan.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Times every scanner is run, the best run being reported.
+ */
+#define RUNS 5
+
+/**
+ * @brief Sum of the scanned highways, printed so that they can not be optimized
+ * away.
+ */
+long checksum = 0;
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Gets the current time of a monotonic clock.
+ *
+ * @return double time in milliseconds
+ */
+double now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/**
+ * @brief Writes the highway section of a random plan, one "city_1 city_2 cost" line
+ * per highway as bin/gen does.
+ *
+ * @param n number of highways
+ * @param max_city largest city id
+ * @param max_cost largest cost
+ * @param length where the length of the text is stored
+ *
+ * @return char* text of the highways or NULL if it could not be allocated
+ */
+char *highway_text(int n, int max_city, int max_cost, long *length) {
+  char *text = malloc((size_t) n * 36 + 1);
+  unsigned long state = 88172645463325252UL;
+  long size = 0;
+  int i = 0;
+
+  if (NULL == text) return NULL;
+  for (i = 0; i < n; i++) {
+    unsigned long a, b, c;
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17; a = state;
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17; b = state;
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17; c = state;
+    size += sprintf(text + size, "%lu %lu %lu\n", a % max_city + 1, b % max_city + 1, c % max_cost + 1);
+  }
+
+  *length = size;
+  return text;
+}
+
+/**
+ * @brief Scans the text with a SIMD level, keeping the best of RUNS runs.
+ *
+ * @param text highway section to scan
+ * @param length length of the text
+ * @param hs where the highways are stored
+ * @param n number of highways in the text
+ * @param simd level to scan with
+ *
+ * @return double best time in milliseconds
+ */
+double time_scan(const char *text, long length, Highway hs, int n, enum scan_simd simd) {
+  double best = 0;
+  int run = 0, overflow = 0;
+
+  for (run = 0; run < RUNS; run++) {
+    struct input in;
+    double start = 0, elapsed = 0;
+
+    memset(&in, 0, sizeof(in));
+    in.data = in.cursor = text;
+    in.end = text + length;
+    in.fd = -1;
+    in.eof = 1;
+
+    start = now_ms();
+    checksum += scan_highways_simd(&in, hs, n, &overflow, simd);
+    elapsed = now_ms() - start;
+    checksum += hs[n - 1].cost;
+    if (run == 0 || elapsed < best) best = elapsed;
+  }
+
+  return best;
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+/**
+ * @brief Compares the scalar scanner with the SIMD ones the processor supports, on
+ * regional plans (small ids and costs) and on wide ones (up to 8 digits).
+ *
+ * @param argc number of arguments
+ * @param argv optional number of highways (1 << 22 by default)
+ *
+ * @return int 0 for success or 1 for error
+ */
+int main(int argc, char *argv[]) {
+  const char *simd_names[] = {"scalar", "sse2", "avx2"};
+  const char *shape_names[] = {"regional", "wide"};
+  int max_cities[] = {60000, 20000000}, max_costs[] = {1000, 99999999};
+  int n = argc > 1 ? atoi(argv[1]) : 1 << 22, shape, simd;
+  enum scan_simd best = scan_best_simd();
+  Highway hs = malloc((size_t) (n > 0 ? n : 1) * sizeof(struct highway));
+
+  if (n < 1 || NULL == hs) {
+    fprintf(stderr, "usage: %s [n_highways]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%-10s %-8s %10s %10s\n", "plan", "scanner", "ms", "MB/s");
+  for (shape = 0; shape < 2; shape++) {
+    long length = 0;
+    char *text = highway_text(n, max_cities[shape], max_costs[shape], &length);
+
+    if (NULL == text) return 1;
+    for (simd = SCAN_SCALAR; simd <= (int) best; simd++) {
+      double ms = time_scan(text, length, hs, n, (enum scan_simd) simd);
+      printf("%-10s %-8s %10.2f %10.1f\n", shape_names[shape], simd_names[simd], ms, length / 1e3 / ms);
+    }
+    free(text);
+  }
+
+  fprintf(stderr, "checksum %ld\n", checksum);
+  free(hs);
+  return 0;
+}
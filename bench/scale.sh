@@ -0,0 +1,44 @@
+#!/bin/sh
+# Runs the planner on generated plans of growing size and records the wall time,
+# the time of every phase and the peak resident memory of each run.
+#
+# usage: bench/scale.sh [highways...]
+#
+# Environment:
+#   BENCH_TOPOLOGIES  topologies to generate (random grid geometric power-law)
+#   BENCH_ENGINE      engine of the planner (kruskal)
+#   BENCH_DENSITY     highways per city (10)
+#   BENCH_OUTPUT      file the results are appended to (./bench_output.txt)
+
+topologies=${BENCH_TOPOLOGIES:-random grid geometric power-law}
+engine=${BENCH_ENGINE:-kruskal}
+density=${BENCH_DENSITY:-10}
+output=${BENCH_OUTPUT:-./bench_output.txt}
+input=./bin/bench_input.txt
+
+# Pulls a number out of the stats line of the planner
+field() {
+  sed -n "s/.*\"$1\":\([0-9.]*\).*/\1/p" ./bin/bench_stats.txt
+}
+
+printf '%-10s %-10s %-10s %-8s %9s %9s %9s %9s %12s\n' \
+  highways cities topology engine wall_s parse_s sort_s mst_s max_rss_kb | tee -a "$output"
+
+for highways in "$@"; do
+  cities=$((highways / density))
+  [ "$cities" -lt 2 ] && cities=2
+
+  for topology in $topologies; do
+    ./bin/gen --cities="$cities" --highways="$highways" --topology="$topology" > "$input" || exit 1
+
+    start=$(date +%s%N)
+    ./bin/main --engine="$engine" --stats "$input" > /dev/null 2> ./bin/bench_stats.txt || exit 1
+    end=$(date +%s%N)
+
+    printf '%-10s %-10s %-10s %-8s %9.3f %9.3f %9.3f %9.3f %12s\n' \
+      "$highways" "$cities" "$topology" "$engine" "$(awk "BEGIN { print ($end - $start) / 1e9 }")" \
+      "$(field parse)" "$(field sort)" "$(field mst)" "$(field max_rss_kb)" | tee -a "$output"
+  done
+done
+
+rm -f "$input" ./bin/bench_stats.txt
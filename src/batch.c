@@ -0,0 +1,282 @@
+#include "stdlib.h"
+#include "string.h"
+#include "pthread.h"
+
+#include "plan.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Plans waiting to be solved by a worker. The owner takes them from the top
+ * and thieves from the bottom.
+ *
+ * @param lock protects top and bottom
+ * @param top next plan the owner is going to solve
+ * @param bottom one past the last plan that is still waiting
+ */
+struct deque {
+  pthread_mutex_t lock;
+  int top;
+  int bottom;
+};
+
+/**
+ * @brief Outcome of a plan of the batch.
+ *
+ * @param worker worker whose output holds the outcome
+ * @param offset where the outcome starts in the output of the worker
+ * @param length length of the outcome
+ * @param status 0 for success or a failure as returned by plan_solve_batch()
+ */
+struct instance {
+  int worker;
+  size_t offset;
+  size_t length;
+  int status;
+};
+
+/**
+ * @brief Shared state of a batch.
+ *
+ * @param options configuration of the plan of every worker
+ * @param in input holding the batch
+ * @param starts where every plan starts in the input, plus where the last one ends
+ * @param instances outcome of every plan
+ * @param deques plans waiting on every worker
+ * @param outputs memory writers holding the outcomes of every worker until every
+ * plan is solved
+ * @param n_plans number of plans in the batch
+ * @param n_workers number of workers the plans were split between
+ */
+struct batch {
+  struct plan_options options;
+  Input in;
+  const char **starts;
+  struct instance *instances;
+  struct deque *deques;
+  struct writer *outputs;
+  int n_plans;
+  int n_workers;
+};
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Gets the next plan a worker should solve: its own next one or, once it has
+ * none left, one stolen from the bottom of another worker.
+ *
+ * @param batch batch being solved
+ * @param self index of the worker
+ *
+ * @return int index of the plan or -1 if every plan was taken
+ */
+static int batch_next(struct batch *batch, int self) {
+  int k = 0, i = -1;
+
+  /* Plans of workers that could not be started are left for thieves */
+  for (k = 0; k < batch->n_workers && i < 0; k++) {
+    struct deque *d = &batch->deques[(self + k) % batch->n_workers];
+
+    pthread_mutex_lock(&d->lock);
+    if (d->top < d->bottom) {
+      i = k == 0 ? d->top++ : --d->bottom;
+    }
+    pthread_mutex_unlock(&d->lock);
+  }
+
+  return i;
+}
+
+/**
+ * @brief Loop of a worker. Solves plans in its own plan context until every plan of
+ * the batch was taken.
+ *
+ * @param arg struct batch being solved
+ * @param thread index of the worker
+ * @param n_threads number of workers (unused)
+ */
+static void batch_worker(void *arg, int thread, int n_threads) {
+  struct batch *batch = arg;
+  Writer w = &batch->outputs[thread];
+  Plan plan = plan_create(&batch->options);
+  int i = 0, solved = 0;
+  (void) n_threads;
+
+  while ((i = batch_next(batch, thread)) >= 0) {
+    struct instance *instance = &batch->instances[i];
+    struct input view = *batch->in;
+
+    view.cursor = batch->starts[i];
+    view.end = batch->starts[i + 1];
+    view.overflow = 0;
+
+    instance->worker = thread;
+    instance->offset = w->size;
+    if (NULL == plan) {
+      instance->status = -5;
+    } else if (plan_load(plan, &view) != 0) {
+      instance->status = -1;
+    } else if ((solved = plan_solve(plan)) != 0) {
+      instance->status = solved - 1;
+    } else {
+      plan_write(plan, w);
+    }
+    instance->length = w->size - instance->offset;
+  }
+
+  plan_destroy(plan);
+}
+
+/**
+ * @brief Solves the plans one after the other in a single plan context, printing
+ * each outcome as soon as it is known.
+ *
+ * @param in input positioned at the first plan of the batch
+ * @param n_plans number of plans in the batch
+ * @param options configuration of every plan
+ * @param out writer to write the outcomes to
+ *
+ * @return int 0 for success or a failure as returned by plan_solve_batch()
+ */
+static int batch_serial(Input in, int n_plans, const struct plan_options *options, Writer out) {
+  Plan plan = plan_create(options);
+  int i = 0, status = 0, solved = 0;
+
+  if (NULL == plan) return -5;
+
+  for (i = 0; i < n_plans && status == 0; i++) {
+    if (plan_load(plan, in) != 0) {
+      status = -1;
+    } else if ((solved = plan_solve(plan)) != 0) {
+      status = solved - 1;
+    } else {
+      plan_write(plan, out);
+    }
+  }
+
+  plan_destroy(plan);
+  return status;
+}
+
+/**
+ * @brief Frees the shared state of a batch.
+ *
+ * @param batch batch to free
+ * @param n_workers number of workers
+ */
+static void batch_free(struct batch *batch, int n_workers) {
+  int w = 0;
+
+  for (w = 0; NULL != batch->deques && w < n_workers; w++) {
+    pthread_mutex_destroy(&batch->deques[w].lock);
+  }
+  for (w = 0; NULL != batch->outputs && w < n_workers; w++) {
+    writer_close(&batch->outputs[w]);
+  }
+  free(batch->starts);
+  free(batch->instances);
+  free(batch->deques);
+  free(batch->outputs);
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+int plan_solve_batch(Input in, int n_plans, const struct plan_options *options, Writer out) {
+  struct batch batch;
+  struct plan_options plan_options;
+  Pool pool = NULL;
+  int n_workers = 0, i = 0, w = 0, status = 0;
+
+  memset(&plan_options, 0, sizeof(plan_options));
+  if (NULL != options) plan_options = *options;
+
+  /* Every plan has to be read whole to find the next one, so streamed highways are
+   * loaded and planned by kruskal as they are read, and external ones are sorted in
+   * memory */
+  if (plan_options.engine == ENGINE_STREAM) {
+    plan_options.engine = ENGINE_KRUSKAL;
+    plan_options.sorted = 1;
+  } else if (plan_options.engine == ENGINE_EXTERNAL) {
+    plan_options.engine = ENGINE_KRUSKAL;
+  }
+
+  /* Plans are already solved in parallel, and counting the chunks of a plan would
+   * scan every plan after it */
+  plan_options.parse = PARSE_SERIAL;
+
+  pool = plan_options.pool;
+  n_workers = plan_options.n_threads;
+  if (n_workers <= 0) n_workers = NULL != pool ? pool_size(pool) : pool_default_size();
+  if (n_workers > n_plans) n_workers = n_plans > 0 ? n_plans : 1;
+
+  /* Workers load their plans from where they start in the input, which only stays
+   * valid for an input held whole in memory */
+  if (n_workers == 1 || in->fd >= 0) return batch_serial(in, n_plans, &plan_options, out);
+
+  /* Every plan is solved single-threaded inside a worker */
+  memset(&batch, 0, sizeof(batch));
+  batch.options = plan_options;
+  batch.options.n_threads = 1;
+  batch.options.pool = NULL;
+  batch.in = in;
+  batch.n_plans = n_plans;
+  batch.n_workers = n_workers;
+  batch.starts = malloc((n_plans + 1) * sizeof(const char *));
+  batch.instances = calloc(n_plans, sizeof(struct instance));
+  batch.deques = calloc(n_workers, sizeof(struct deque));
+  batch.outputs = calloc(n_workers, sizeof(struct writer));
+  if (NULL == batch.starts || NULL == batch.instances || NULL == batch.deques || NULL == batch.outputs) {
+    batch_free(&batch, 0);
+    return -5;
+  }
+
+  /* Finds where every plan starts so that workers can load them independently */
+  for (i = 0; i < n_plans; i++) {
+    batch.starts[i] = in->cursor;
+    plan_skip(in);
+  }
+  batch.starts[n_plans] = in->cursor;
+
+  /* Each worker starts off with a contiguous run of plans */
+  for (w = 0; w < n_workers; w++) {
+    pthread_mutex_init(&batch.deques[w].lock, NULL);
+    batch.deques[w].top = (int) ((long) n_plans * w / n_workers);
+    batch.deques[w].bottom = (int) ((long) n_plans * (w + 1) / n_workers);
+    writer_init_memory(&batch.outputs[w]);
+  }
+
+  if (NULL == pool || pool_size(pool) != n_workers) {
+    Pool own = pool_create(n_workers);
+    if (NULL == own) {
+      batch_free(&batch, n_workers);
+      return -6;
+    }
+    pool_run(own, batch_worker, &batch);
+    pool_destroy(own);
+  } else {
+    pool_run(pool, batch_worker, &batch);
+  }
+
+  /* Prints the outcomes in input order, up to the first plan that failed */
+  for (i = 0; i < n_plans && status == 0; i++) {
+    struct instance *instance = &batch.instances[i];
+    status = instance->status;
+    if (status == 0) {
+      if (writer_reserve(out, instance->length) != 0) {
+        status = -5;
+        break;
+      }
+      memcpy(out->buffer + out->size, batch.outputs[instance->worker].buffer + instance->offset, instance->length);
+      out->size += instance->length;
+    }
+  }
+
+  batch_free(&batch, n_workers);
+  return status;
+}
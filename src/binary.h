@@ -0,0 +1,69 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include "stdint.h"
+
+#include "highway.h"
+
+
+/* ################################ Format ################################# */
+
+
+/**
+ * @brief Binary plans start with these bytes, so that they can be told apart from
+ * text plans, which start with a number.
+ */
+#define PLAN_MAGIC "NAVY"
+
+/**
+ * @brief Version of the binary format.
+ */
+#define PLAN_VERSION 1
+
+/**
+ * @brief Flag set when the highways are sorted by increasing cost.
+ */
+#define PLAN_SORTED 1
+
+/**
+ * @brief Flag set when costs are 64 bits wide. A plan can only be loaded by a build
+ * whose cost_t has the same width.
+ */
+#define PLAN_COST_64 2
+
+/**
+ * @brief Header of a binary plan. It is followed by n_ports struct plan_port and
+ * then by n_highways struct highway, exactly as they are laid out in memory, so
+ * that the highways can be used in place. Everything is in native byte order; a
+ * plan written on a machine of the other order fails the version check.
+ *
+ * @param magic PLAN_MAGIC
+ * @param version PLAN_VERSION
+ * @param flags PLAN_SORTED and PLAN_COST_64
+ * @param n_cities number of cities
+ * @param n_ports number of ports
+ * @param n_highways number of highways
+ * @param reserved 0, keeps the arrays 8-byte aligned
+ */
+struct plan_header {
+  char magic[4];
+  uint16_t version;
+  uint16_t flags;
+  int32_t n_cities;
+  int32_t n_ports;
+  int32_t n_highways;
+  int32_t reserved;
+};
+
+/**
+ * @brief Port of a binary plan.
+ *
+ * @param city city the port is built in
+ * @param cost cost of building the port
+ */
+struct plan_port {
+  int32_t city;
+  cost_t cost;
+};
+
+#endif
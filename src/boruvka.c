@@ -0,0 +1,148 @@
+#include "stdlib.h"
+
+#include "plan.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Shared state of a round of the Boruvka engine.
+ * 
+ * @param highways highways of the plan, compacted in place by every round
+ * @param capital index of the capital of every city at the start of the round
+ * @param cheapest index of the cheapest highway leaving each component (-1 if none)
+ * @param live number of highways still worth looking at in the slice of each thread
+ * @param chunk size of the slice of highways owned by each thread
+ */
+struct boruvka_round {
+  Highway highways;
+  int *capital;
+  int *cheapest;
+  int *live;
+  int chunk;
+};
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Total order used to pick the cheapest highway of a component, ties on the
+ * cost being broken by position so that no cycle can be picked in a round.
+ * 
+ * @param hs highways of the plan
+ * @param e index of a highway
+ * @param f index of another highway
+ * 
+ * @return int 1 if e comes before f and 0 if not
+ */
+static inline int highway_is_cheaper(Highway hs, int e, int f) {
+  return hs[e].cost < hs[f].cost || (hs[e].cost == hs[f].cost && e < f);
+}
+
+/**
+ * @brief Proposes a highway as the cheapest one leaving a component. Several
+ * threads may propose for the same component, so the slot is updated with CAS.
+ * 
+ * @param hs highways of the plan
+ * @param slot cheapest highway of the component
+ * @param e index of the proposed highway
+ */
+static void offer_cheapest(Highway hs, int *slot, int e) {
+  int current = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+
+  while (current == -1 || highway_is_cheaper(hs, e, current)) {
+    if (__atomic_compare_exchange_n(slot, &current, e, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Scans the slice of highways of a thread, proposing each one to both of
+ * its components. Highways inside a single component are never useful again and
+ * are compacted out of the slice.
+ * 
+ * @param arg struct boruvka_round of the current round
+ * @param thread index of the thread and of its slice
+ * @param n_threads number of threads (unused)
+ */
+static void boruvka_scan(void *arg, int thread, int n_threads) {
+  struct boruvka_round *round = arg;
+  Highway hs = round->highways;
+  int lo = thread * round->chunk, hi = lo + round->live[thread], kept = lo, i = 0;
+  (void) n_threads;
+
+  for (i = lo; i < hi; i++) {
+    struct highway h = hs[i];
+    int c1 = round->capital[h.city_1], c2 = round->capital[h.city_2];
+
+    if (c1 == c2) continue;
+
+    hs[kept] = h;
+    offer_cheapest(hs, &round->cheapest[c1], kept);
+    offer_cheapest(hs, &round->cheapest[c2], kept);
+    kept++;
+  }
+
+  round->live[thread] = kept - lo;
+}
+
+
+/* ############################# MST Algorithm ############################# */
+
+
+int boruvka(Plan plan) {
+  struct boruvka_round round;
+  int size = pool_size(plan->pool), merged = 1, t = 0, v = 0;
+
+  round.highways = plan->highways;
+  round.chunk = (plan->n_highways + size - 1) / size;
+  round.capital = malloc((plan->n_cities + 1) * sizeof(int));
+  round.cheapest = malloc((plan->n_cities + 1) * sizeof(int));
+  round.live = malloc(size * sizeof(int));
+  if (NULL == round.capital || NULL == round.cheapest || NULL == round.live) {
+    free(round.capital);
+    free(round.cheapest);
+    free(round.live);
+    return -1;
+  }
+
+  for (t = 0; t < size; t++) {
+    int left = plan->n_highways - t * round.chunk;
+    round.live[t] = left < 0 ? 0 : (left < round.chunk ? left : round.chunk);
+  }
+
+  while (plan->n_components > 1 && merged) {
+    for (v = 1; v <= plan->n_cities; v++) {
+      round.capital[v] = dsu_find(&plan->dsu, v);
+      round.cheapest[v] = -1;
+    }
+    for (t = 0; t < size; t++) {
+      plan->stats.edges_scanned += round.live[t];
+    }
+
+    pool_run(plan->pool, boruvka_scan, &round);
+
+    /* Builds the cheapest highway of every component, skipping the ones that were
+     * picked from both sides */
+    for (merged = 0, v = 1; v <= plan->n_cities; v++) {
+      int e = round.cheapest[v], v1 = 0, v2 = 0;
+
+      if (round.capital[v] != v || e == -1) continue;
+
+      v1 = dsu_find(&plan->dsu, round.highways[e].city_1);
+      v2 = dsu_find(&plan->dsu, round.highways[e].city_2);
+      if (v1 != v2) {
+        build_highway(plan, v1, v2, &round.highways[e]);
+        merged = 1;
+      }
+    }
+  }
+
+  free(round.capital);
+  free(round.cheapest);
+  free(round.live);
+  return 0;
+}
@@ -0,0 +1,61 @@
+#include "stdlib.h"
+
+#include "dsu.h"
+
+
+int dsu_init(Dsu dsu, int n) {
+  int i;
+
+  if (n > dsu->capacity) {
+    dsu_free(dsu);
+    dsu->parent = malloc((size_t) n * sizeof(int32_t));
+    dsu->size = malloc((size_t) n * sizeof(int32_t));
+    if (NULL == dsu->parent || NULL == dsu->size) {
+      dsu_free(dsu);
+      return -1;
+    }
+    dsu->capacity = n;
+  }
+  dsu->n = n;
+  dsu->finds = dsu->path_length = dsu->unions = 0;
+
+  /* Each element starts off as its own capital */
+  for (i = 0; i < n; i++) {
+    dsu->parent[i] = i;
+    dsu->size[i] = 1;
+  }
+
+  return 0;
+}
+
+void dsu_free(Dsu dsu) {
+  free(dsu->parent);
+  free(dsu->size);
+  dsu->parent = NULL;
+  dsu->size = NULL;
+  dsu->n = dsu->capacity = 0;
+}
+
+int cdsu_init(Cdsu dsu, int n) {
+  int i;
+
+  if (n > dsu->capacity) {
+    cdsu_free(dsu);
+    dsu->parent = malloc((size_t) n * sizeof(int32_t));
+    if (NULL == dsu->parent) return -1;
+    dsu->capacity = n;
+  }
+  dsu->n = n;
+
+  for (i = 0; i < n; i++) {
+    dsu->parent[i] = i;
+  }
+
+  return 0;
+}
+
+void cdsu_free(Cdsu dsu) {
+  free(dsu->parent);
+  dsu->parent = NULL;
+  dsu->n = dsu->capacity = 0;
+}
@@ -0,0 +1,291 @@
+#ifndef DSU_H
+#define DSU_H
+
+#include "stdint.h"
+
+
+/**
+ * @brief Path compression strategies of dsu_find(), chosen at build time with
+ * -D FIND_MODE=<strategy>.
+ */
+#define FIND_RECURSIVE 0
+#define FIND_HALVING 1
+#define FIND_SPLITTING 2
+
+#ifndef FIND_MODE
+#define FIND_MODE FIND_HALVING
+#endif
+
+/**
+ * @brief Disjoint set of cities stored as separate arrays indexed by city, so that
+ * finds only pull parents into the cache.
+ * 
+ * @param parent capital of every city in its MST sub-tree (itself for capitals)
+ * @param size number of connected cities under every capital
+ * @param n number of elements
+ * @param capacity number of elements the arrays have room for
+ * @param finds number of dsu_find() calls since the last dsu_init()
+ * @param path_length number of parents walked by those finds
+ * @param unions number of dsu_link() calls since the last dsu_init()
+ */
+typedef struct dsu {
+  int32_t *parent;
+  int32_t *size;
+  int n;
+  int capacity;
+  int64_t finds;
+  int64_t path_length;
+  int64_t unions;
+} *Dsu;
+
+/**
+ * @brief Resets a disjoint set so that every element is on its own. The arrays are
+ * only reallocated when they have no room for n elements, so a disjoint set can be
+ * reused across plans.
+ * 
+ * @param dsu disjoint set to initialize (zeroed or previously initialized)
+ * @param n number of elements
+ * 
+ * @return int 0 for success or -1 if it could not be allocated
+ */
+int dsu_init(Dsu dsu, int n);
+
+/**
+ * @brief Frees the arrays of a disjoint set.
+ * 
+ * @param dsu disjoint set to free
+ */
+void dsu_free(Dsu dsu);
+
+/**
+ * @brief Finds the capital of an element. The path compression strategy is chosen
+ * at build time with FIND_MODE: iterative path halving (default), iterative path
+ * splitting or recursive full compression. Every call and every parent walked is
+ * counted.
+ * 
+ * @param dsu disjoint set
+ * @param x element to look for the capital
+ * 
+ * @return int capital of x
+ */
+static inline int dsu_find(Dsu dsu, int x) {
+  int32_t *parent = dsu->parent;
+#if FIND_MODE == FIND_RECURSIVE
+  /* Every recursion ends at the capital exactly once */
+  if (parent[x] == x) {
+    dsu->finds++;
+    return x;
+  }
+  dsu->path_length++;
+  parent[x] = dsu_find(dsu, parent[x]);
+  return parent[x];
+#elif FIND_MODE == FIND_SPLITTING
+  int64_t length = 0;
+
+  /* Every element on the path is pointed to its grandparent */
+  while (parent[x] != x) {
+    int p = parent[x];
+    parent[x] = parent[p];
+    x = p;
+    length++;
+  }
+  dsu->finds++;
+  dsu->path_length += length;
+  return x;
+#else
+  int64_t length = 0;
+
+  /* Every other element on the path is pointed to its grandparent */
+  while (parent[x] != x) {
+    parent[x] = parent[parent[x]];
+    x = parent[x];
+    length++;
+  }
+  dsu->finds++;
+  dsu->path_length += length;
+  return x;
+#endif
+}
+
+/**
+ * @brief Finds the capital of an element without compressing its path or counting
+ * the call, so that several threads can query a disjoint set that nobody modifies
+ * meanwhile.
+ * 
+ * @param dsu disjoint set
+ * @param x element to look for the capital
+ * @param length incremented by the number of parents walked
+ * 
+ * @return int capital of x
+ */
+static inline int dsu_find_const(const struct dsu *dsu, int x, int64_t *length) {
+  const int32_t *parent = dsu->parent;
+
+  while (parent[x] != x) {
+    x = parent[x];
+    (*length)++;
+  }
+  return x;
+}
+
+/**
+ * @brief Links two different capitals, attaching the smaller tree under the
+ * capital of the bigger one.
+ * 
+ * @param dsu disjoint set
+ * @param x capital of one of the sets
+ * @param y capital of the other set
+ * 
+ * @return int capital of the merged set
+ */
+static inline int dsu_link(Dsu dsu, int x, int y) {
+  if (dsu->size[x] < dsu->size[y]) {
+    int t = x;
+    x = y;
+    y = t;
+  }
+  dsu->parent[y] = x;
+  dsu->size[x] += dsu->size[y];
+  dsu->unions++;
+  return x;
+}
+
+/**
+ * @brief Disjoint set that several threads can find and link at once, without
+ * locks. Capitals are linked with CAS in a fixed pseudo-random order of the
+ * elements, so that parents always come later in that order and no cycle can
+ * form, and paths are split by finds whose CAS may harmlessly lose a race.
+ * Nothing is counted, as the counters would be shared by every thread. No engine
+ * uses it yet, they all link with dsu_link() from a single thread.
+ * 
+ * @param parent capital of every element in its sub-tree (itself for capitals)
+ * @param n number of elements
+ * @param capacity number of elements the array has room for
+ */
+typedef struct cdsu {
+  int32_t *parent;
+  int n;
+  int capacity;
+} *Cdsu;
+
+/**
+ * @brief Resets a concurrent disjoint set so that every element is on its own, as
+ * dsu_init() does. It must not be used by any thread meanwhile.
+ * 
+ * @param dsu concurrent disjoint set to initialize (zeroed or previously initialized)
+ * @param n number of elements
+ * 
+ * @return int 0 for success or -1 if it could not be allocated
+ */
+int cdsu_init(Cdsu dsu, int n);
+
+/**
+ * @brief Frees the array of a concurrent disjoint set.
+ * 
+ * @param dsu concurrent disjoint set to free
+ */
+void cdsu_free(Cdsu dsu);
+
+/**
+ * @brief Gets the place of an element in the linking order: a bijective mix of its
+ * index, which keeps trees shallow in expectation whatever the order of the links.
+ * 
+ * @param x element
+ * 
+ * @return uint32_t place of x, distinct for every element
+ */
+static inline uint32_t cdsu_priority(int x) {
+  uint32_t h = (uint32_t) x;
+
+  h ^= h >> 16;
+  h *= 0x7FEB352DU;
+  h ^= h >> 15;
+  h *= 0x846CA68BU;
+  h ^= h >> 16;
+  return h;
+}
+
+/**
+ * @brief Finds the capital of an element with path splitting, as FIND_SPLITTING
+ * does for dsu_find(). Every element on the path is pointed to its grandparent with
+ * a single CAS that is not retried: losing it to another thread only leaves a
+ * longer path, never a wrong one. The capital
+ * returned was one at some point of the call, and may since have been linked.
+ * 
+ * @param dsu concurrent disjoint set
+ * @param x element to look for the capital
+ * 
+ * @return int capital of x
+ */
+static inline int cdsu_find(Cdsu dsu, int x) {
+  int32_t *parent = dsu->parent;
+  int32_t p = __atomic_load_n(&parent[x], __ATOMIC_ACQUIRE);
+
+  while (p != x) {
+    int32_t grandparent = __atomic_load_n(&parent[p], __ATOMIC_ACQUIRE);
+
+    if (grandparent != p) {
+      int32_t expected = p;
+      __atomic_compare_exchange_n(&parent[x], &expected, grandparent, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+    x = p;
+    p = grandparent;
+  }
+
+  return x;
+}
+
+/**
+ * @brief Checks whether two elements are in the same set, which links by other
+ * threads may change right after the call.
+ * 
+ * @param dsu concurrent disjoint set
+ * @param x element
+ * @param y another element
+ * 
+ * @return int 1 if they were in the same set and 0 if not
+ */
+static inline int cdsu_same(Cdsu dsu, int x, int y) {
+  while (1) {
+    x = cdsu_find(dsu, x);
+    y = cdsu_find(dsu, y);
+    if (x == y) return 1;
+
+    /* Different capitals only prove different sets if x is still one */
+    if (__atomic_load_n(&dsu->parent[x], __ATOMIC_ACQUIRE) == x) return 0;
+  }
+}
+
+/**
+ * @brief Merges the sets of two elements, the capital that comes first in the
+ * linking order being attached under the other one with CAS. A capital that gets
+ * linked by another thread meanwhile makes the CAS fail, and the capitals are
+ * then looked for again.
+ * 
+ * @param dsu concurrent disjoint set
+ * @param x element
+ * @param y another element
+ * 
+ * @return int 1 if this call merged two sets and 0 if they were already the same
+ */
+static inline int cdsu_union(Cdsu dsu, int x, int y) {
+  while (1) {
+    int32_t expected = 0;
+
+    x = cdsu_find(dsu, x);
+    y = cdsu_find(dsu, y);
+    if (x == y) return 0;
+
+    if (cdsu_priority(x) > cdsu_priority(y)) {
+      int t = x;
+      x = y;
+      y = t;
+    }
+    expected = x;
+    if (__atomic_compare_exchange_n(&dsu->parent[x], &expected, y, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      return 1;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,278 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "limits.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+
+#include "plan.h"
+#include "sort.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Bytes used to sort each run when the plan does not set a limit.
+ */
+#define EXTERNAL_DEFAULT_MEMORY ((size_t) 1 << 30)
+
+/**
+ * @brief Number of highways read at once from each run while merging.
+ */
+#define RUN_BUFFER_SIZE 4096
+
+/**
+ * @brief Sorted run of highways stored in the temporary file.
+ *
+ * @param offset where the next highways of the run start in the file
+ * @param left number of highways of the run that were not read yet
+ * @param buffer highways read from the run
+ * @param next next highway of buffer to merge
+ * @param count number of highways in buffer
+ */
+struct run {
+  off_t offset;
+  int64_t left;
+  Highway buffer;
+  int next;
+  int count;
+};
+
+/**
+ * @brief State of the external engine.
+ *
+ * @param fd temporary file holding the runs, already unlinked
+ * @param runs runs written to the file
+ * @param n_runs number of runs
+ * @param heap indexes of the runs that are not exhausted, as a min-heap on the
+ * cost of their next highway
+ * @param n_heap number of runs in the heap
+ */
+struct external {
+  int fd;
+  struct run *runs;
+  int n_runs;
+  int *heap;
+  int n_heap;
+};
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Creates the temporary file in $TMPDIR (or /tmp) and unlinks it right away,
+ * so that it goes away with the process however it ends.
+ *
+ * @return int file descriptor or -1 for error
+ */
+static int external_open(void) {
+  const char *dir = NULL != getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+  char *path = malloc(strlen(dir) + sizeof("/navyplan.XXXXXX"));
+  int fd = -1;
+
+  if (NULL == path) return -1;
+  strcpy(path, dir);
+  strcat(path, "/navyplan.XXXXXX");
+
+  fd = mkstemp(path);
+  if (fd >= 0) unlink(path);
+  free(path);
+  return fd;
+}
+
+/**
+ * @brief Sorts a run and appends it to the temporary file.
+ *
+ * @param ext state of the engine
+ * @param hs highways of the run
+ * @param n number of highways in hs
+ * @param scratch sort buffer with room for n highways
+ * @param offset where the run starts in the file, moved past it
+ *
+ * @return int 0 for success or -1 for error
+ */
+static int external_write_run(struct external *ext, Highway hs, int n, Highway scratch, off_t *offset) {
+  struct run *runs = realloc(ext->runs, (ext->n_runs + 1) * sizeof(struct run));
+  const char *p = (const char *) hs;
+  size_t size = n * sizeof(struct highway), done = 0;
+
+  if (NULL == runs) return -1;
+  ext->runs = runs;
+
+  sort_highways(hs, n, scratch);
+  while (done < size) {
+    ssize_t written = write(ext->fd, p + done, size - done);
+    if (written <= 0) return -1;
+    done += (size_t) written;
+  }
+
+  memset(&runs[ext->n_runs], 0, sizeof(struct run));
+  runs[ext->n_runs].offset = *offset;
+  runs[ext->n_runs].left = n;
+  ext->n_runs++;
+  *offset += (off_t) size;
+  return 0;
+}
+
+/**
+ * @brief Reads the next highways of a run into its buffer.
+ *
+ * @param ext state of the engine
+ * @param run run to read
+ *
+ * @return int 0 for success or -1 for error
+ */
+static int run_fill(struct external *ext, struct run *run) {
+  int n = run->left < RUN_BUFFER_SIZE ? (int) run->left : RUN_BUFFER_SIZE;
+  size_t size = n * sizeof(struct highway), done = 0;
+
+  while (done < size) {
+    ssize_t got = pread(ext->fd, (char *) run->buffer + done, size - done, run->offset + (off_t) done);
+    if (got <= 0) return -1;
+    done += (size_t) got;
+  }
+
+  run->offset += (off_t) size;
+  run->left -= n;
+  run->next = 0;
+  run->count = n;
+  return 0;
+}
+
+/**
+ * @brief Cost of the next highway of the run at a position of the heap.
+ */
+#define HEAP_COST(ext, i) ((ext)->runs[(ext)->heap[i]].buffer[(ext)->runs[(ext)->heap[i]].next].cost)
+
+/**
+ * @brief Moves the run at a position of the heap down until both of its children
+ * come after it.
+ *
+ * @param ext state of the engine
+ * @param i position of the run in the heap
+ */
+static void heap_sift_down(struct external *ext, int i) {
+  int child = 0, top = ext->heap[i];
+
+  while ((child = 2 * i + 1) < ext->n_heap) {
+    if (child + 1 < ext->n_heap && HEAP_COST(ext, child + 1) < HEAP_COST(ext, child)) child++;
+    ext->heap[i] = top;
+    if (HEAP_COST(ext, i) <= HEAP_COST(ext, child)) break;
+    ext->heap[i] = ext->heap[child];
+    i = child;
+  }
+  ext->heap[i] = top;
+}
+
+/**
+ * @brief Merges the runs in cost order, planning each highway, until every city is
+ * connected or every run is exhausted.
+ *
+ * @param plan plan being solved
+ * @param ext state of the engine with every run written
+ *
+ * @return int 0 for success or -1 for error
+ */
+static int external_merge(Plan plan, struct external *ext) {
+  int i = 0;
+
+  ext->heap = malloc(ext->n_runs * sizeof(int));
+  if (NULL == ext->heap) return -1;
+
+  for (i = 0; i < ext->n_runs; i++) {
+    ext->runs[i].buffer = malloc(RUN_BUFFER_SIZE * sizeof(struct highway));
+    if (NULL == ext->runs[i].buffer || run_fill(ext, &ext->runs[i]) != 0) return -1;
+    ext->heap[ext->n_heap++] = i;
+  }
+  for (i = ext->n_heap / 2 - 1; i >= 0; i--) {
+    heap_sift_down(ext, i);
+  }
+
+  while (ext->n_heap > 0 && plan->n_components > 1) {
+    struct run *run = &ext->runs[ext->heap[0]];
+    Highway h = &run->buffer[run->next];
+    int v1 = dsu_find(&plan->dsu, h->city_1);
+    int v2 = dsu_find(&plan->dsu, h->city_2);
+
+    if (v1 != v2) {
+      build_highway(plan, v1, v2, h);
+    }
+    plan->stats.edges_scanned++;
+
+    /* Exhausted runs leave the heap, replaced by its last run */
+    if (++run->next == run->count && (run->left == 0 || run_fill(ext, run) != 0)) {
+      if (run->left != 0) return -1;
+      ext->heap[0] = ext->heap[--ext->n_heap];
+    }
+    if (ext->n_heap > 0) heap_sift_down(ext, 0);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Frees the state of the engine and removes its temporary file.
+ *
+ * @param ext state of the engine
+ */
+static void external_free(struct external *ext) {
+  int i = 0;
+
+  for (i = 0; NULL != ext->runs && i < ext->n_runs; i++) {
+    free(ext->runs[i].buffer);
+  }
+  free(ext->runs);
+  free(ext->heap);
+  if (ext->fd >= 0) close(ext->fd);
+}
+
+
+/* ############################# MST Algorithm ############################# */
+
+
+int kruskal_external(Plan plan, Input in) {
+  struct external ext;
+  size_t memory = plan->options.memory > 0 ? plan->options.memory : EXTERNAL_DEFAULT_MEMORY;
+  int64_t run_size = (int64_t) (memory / (2 * sizeof(struct highway))), n_read = 0;
+  Highway hs = NULL, scratch = NULL;
+  off_t offset = 0;
+  int n = 0, status = 0;
+
+  /* A run and its sort buffer share the memory, never holding more than the plan */
+  if (run_size > plan->n_streamed) run_size = plan->n_streamed;
+  if (run_size > INT_MAX) run_size = INT_MAX;
+  if (run_size < RUN_BUFFER_SIZE) run_size = RUN_BUFFER_SIZE;
+
+  memset(&ext, 0, sizeof(ext));
+  ext.fd = -1;
+  hs = malloc(run_size * sizeof(struct highway));
+  scratch = malloc(run_size * sizeof(struct highway));
+  if (NULL == hs || NULL == scratch) status = -1;
+
+  while (status == 0 && n_read < plan->n_streamed) {
+    n = stream_highways(plan, in, hs, plan->n_streamed - n_read < run_size ? (int) (plan->n_streamed - n_read) : (int) run_size);
+    n_read += n;
+
+    /* The whole plan fits in a single run, so it is planned in memory */
+    if (ext.n_runs == 0 && (n < run_size || n_read == plan->n_streamed)) {
+      sort_highways(hs, n, scratch);
+      kruskal(plan, hs, n);
+      break;
+    }
+
+    if (n == 0) break;
+    if (ext.fd < 0) ext.fd = external_open();
+    if (ext.fd < 0 || external_write_run(&ext, hs, n, scratch, &offset) != 0) status = -1;
+    if (n < run_size) break;
+  }
+
+  /* The runs are merged with only their read buffers resident */
+  free(hs);
+  free(scratch);
+  if (status == 0 && ext.n_runs > 0) status = external_merge(plan, &ext);
+
+  external_free(&ext);
+  return status;
+}
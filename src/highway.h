@@ -0,0 +1,67 @@
+#ifndef HIGHWAY_H
+#define HIGHWAY_H
+
+#include "stdint.h"
+#include "inttypes.h"
+
+
+/**
+ * @brief Cost of building a single highway or port. 32 bits by default and 64 bits
+ * when built with -D COST_64.
+ */
+#ifdef COST_64
+typedef int64_t cost_t;
+#define COST_MIN INT64_MIN
+#define COST_MAX INT64_MAX
+#else
+typedef int32_t cost_t;
+#define COST_MIN INT32_MIN
+#define COST_MAX INT32_MAX
+#endif
+
+/**
+ * @brief Total cost of a plan, always accumulated in 64 bits.
+ */
+typedef int64_t plan_cost_t;
+
+/**
+ * @brief printf conversion of a plan cost.
+ */
+#define PRI_PLAN_COST PRId64
+
+/**
+ * @brief Highway configuration that is going to be associated to a city and used
+ * in a linked list.
+ * 
+ * @param city_1 city node whose holder can be connected to through a highway
+ * @param city_2 other city node whose holder can be connected to through a highway
+ * @param cost cost of building this highway
+ */
+typedef struct highway {
+  int city_1;
+  int city_2;
+  cost_t cost;
+} *Highway;
+
+/**
+ * @brief Most cities a plan can have for its highways to be packed into a struct
+ * narrow_highway.
+ */
+#define NARROW_MAX_CITIES UINT16_MAX
+
+/**
+ * @brief Highway packed into 8 bytes, for plans of at most NARROW_MAX_CITIES cities
+ * whose costs all fit in 32 bits. Sorting and scanning these moves two thirds of
+ * the bytes of a struct highway (half with 64-bit costs).
+ * 
+ * @param city_1 city node whose holder can be connected to through a highway
+ * @param city_2 other city node whose holder can be connected to through a highway
+ * @param cost cost of building this highway
+ */
+typedef struct narrow_highway {
+  uint16_t city_1;
+  uint16_t city_2;
+  int32_t cost;
+} *NarrowHighway;
+
+#endif
@@ -0,0 +1,341 @@
+#include "stdlib.h"
+#include "string.h"
+
+#include "plan.h"
+#include "sort.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Filter-Kruskal stops partitioning and sorts the highways once there are
+ * at most this many of them.
+ */
+#define FILTER_KRUSKAL_THRESHOLD (1 << 12)
+
+/**
+ * @brief Number of highways the stream engine reads at once.
+ */
+#define STREAM_CHUNK_SIZE 1024
+
+/**
+ * @brief Filter step shared by the threads of the pool, each one filtering its own
+ * slice of the highways against the disjoint set, which nobody modifies meanwhile.
+ *
+ * @param plan plan being solved
+ * @param hs highways to filter
+ * @param n number of highways in hs
+ * @param n_kept number of highways kept at the start of the slice of every thread
+ * @param path_length number of parents walked by the finds of every thread
+ */
+struct filter_job {
+  Plan plan;
+  Highway hs;
+  int n;
+  int *n_kept;
+  int64_t *path_length;
+};
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Moves the highways whose cost is at most the pivot to the front.
+ * 
+ * @param hs highways to partition
+ * @param n number of highways in hs
+ * @param pivot cost that splits light from heavy highways
+ * 
+ * @return int number of light highways
+ */
+static int partition_highways(Highway hs, int n, cost_t pivot) {
+  int i = 0, n_light = 0;
+  struct highway tmp;
+
+  for (i = 0; i < n; i++) {
+    if (hs[i].cost <= pivot) {
+      tmp = hs[n_light];
+      hs[n_light++] = hs[i];
+      hs[i] = tmp;
+    }
+  }
+
+  return n_light;
+}
+
+/**
+ * @brief Filters the slice of a thread, compacting the highways it keeps to the
+ * start of the slice.
+ * 
+ * @param arg struct filter_job of the filter step
+ * @param thread index of the thread and of its slice
+ * @param n_threads number of threads
+ */
+static void filter_slice(void *arg, int thread, int n_threads) {
+  struct filter_job *job = arg;
+  const struct dsu *dsu = &job->plan->dsu;
+  Highway hs = job->hs;
+  int begin = (int) ((long) job->n * thread / n_threads), end = (int) ((long) job->n * (thread + 1) / n_threads);
+  int i = 0, n_kept = begin;
+  int64_t length = 0;
+
+  for (i = begin; i < end; i++) {
+    if (dsu_find_const(dsu, hs[i].city_1, &length) != dsu_find_const(dsu, hs[i].city_2, &length)) {
+      hs[n_kept++] = hs[i];
+    }
+  }
+
+  job->n_kept[thread] = n_kept - begin;
+  job->path_length[thread] = length;
+}
+
+/**
+ * @brief Filters highways on every thread of the plan, keeping them in the same
+ * order as filter_highways(). Each thread compacts its own slice and the slices are
+ * then moved next to each other.
+ * 
+ * @param plan plan being solved
+ * @param hs highways to filter
+ * @param n number of highways in hs
+ * @param pool threads to filter on, more than one
+ * 
+ * @return int number of highways that can still join two components or -1 if the
+ * filter step could not be allocated
+ */
+static int filter_highways_parallel(Plan plan, Highway hs, int n, Pool pool) {
+  struct filter_job job;
+  int n_threads = pool_size(pool), t = 0, n_kept = 0;
+
+  job.plan = plan;
+  job.hs = hs;
+  job.n = n;
+  job.n_kept = malloc(n_threads * sizeof(int));
+  job.path_length = malloc(n_threads * sizeof(int64_t));
+  if (NULL == job.n_kept || NULL == job.path_length) {
+    free(job.n_kept);
+    free(job.path_length);
+    return -1;
+  }
+
+  pool_run(pool, filter_slice, &job);
+
+  for (t = 0; t < n_threads; t++) {
+    int begin = (int) ((long) n * t / n_threads);
+    memmove(hs + n_kept, hs + begin, job.n_kept[t] * sizeof(struct highway));
+    n_kept += job.n_kept[t];
+    plan->dsu.path_length += job.path_length[t];
+  }
+  plan->dsu.finds += 2L * n;
+  plan->stats.edges_scanned += n;
+
+  free(job.n_kept);
+  free(job.path_length);
+  return n_kept;
+}
+
+/**
+ * @brief Drops the highways whose cities are already in the same component,
+ * compacting the others to the front.
+ * 
+ * @param plan plan being solved
+ * @param hs highways to filter
+ * @param n number of highways in hs
+ * @param pool threads to filter at least PARALLEL_FILTER_THRESHOLD highways on
+ * (NULL to filter serially)
+ * 
+ * @return int number of highways that can still join two components
+ */
+static int filter_highways(Plan plan, Highway hs, int n, Pool pool) {
+  int i = 0, n_kept = 0;
+
+  /* Finds only read the disjoint set until the next union, so threads can share it */
+  if (n >= PARALLEL_FILTER_THRESHOLD && NULL != pool && pool_size(pool) > 1) {
+    n_kept = filter_highways_parallel(plan, hs, n, pool);
+    if (n_kept >= 0) return n_kept;
+    n_kept = 0;
+  }
+
+  for (i = 0; i < n; i++) {
+    if (dsu_find(&plan->dsu, hs[i].city_1) != dsu_find(&plan->dsu, hs[i].city_2)) {
+      hs[n_kept++] = hs[i];
+    }
+  }
+  plan->stats.edges_scanned += n;
+
+  return n_kept;
+}
+
+int stream_highways(Plan plan, Input in, Highway chunk, int n) {
+  int n_read = 0;
+
+  /* Highways after one leading out of the plan are never read */
+  if (plan->invalid_city) return 0;
+  if (plan->binary) {
+    n_read = (int) (input_read_bytes(in, chunk, n * (long) sizeof(struct highway)) / (long) sizeof(struct highway));
+  } else {
+    n_read = scan_highways(in, chunk, n, &plan->cost_overflow);
+  }
+
+  n = highways_in_cities(chunk, n_read, plan->n_cities);
+  plan->invalid_city = n < n_read;
+  return n;
+}
+
+
+/* ############################# MST Algorithm ############################# */
+
+
+void kruskal(Plan plan, Highway hs, int n) {
+  int i = 0;
+
+  /* Loops over all possible highways that can be built to connect the city and chooses the cheapest
+   * for each of the city components that are not yet connected */
+  for (i = 0; i < n && plan->n_components > 1; i++) {
+    Highway h = &hs[i];
+
+    int v1 = dsu_find(&plan->dsu, h->city_1);
+    int v2 = dsu_find(&plan->dsu, h->city_2);
+
+    /* If they are from different city components, we should merge them together */
+    if (v1 != v2) {
+      build_highway(plan, v1, v2, h);
+    }
+  }
+  plan->stats.edges_scanned += i;
+}
+
+void kruskal_narrow(Plan plan, NarrowHighway hs, int n) {
+  int i = 0;
+
+  for (i = 0; i < n && plan->n_components > 1; i++) {
+    NarrowHighway h = &hs[i];
+
+    int v1 = dsu_find(&plan->dsu, h->city_1);
+    int v2 = dsu_find(&plan->dsu, h->city_2);
+
+    /* Built highways are widened back, as that is how they are reported */
+    if (v1 != v2) {
+      struct highway wide;
+      wide.city_1 = h->city_1;
+      wide.city_2 = h->city_2;
+      wide.cost = h->cost;
+      build_highway(plan, v1, v2, &wide);
+    }
+  }
+  plan->stats.edges_scanned += i;
+}
+
+void kruskal_keys(Plan plan, Highway hs, const uint64_t *keys, int n) {
+  int i = 0;
+
+  for (i = 0; i < n && plan->n_components > 1; i++) {
+    Highway h = &hs[(uint32_t) keys[i]];
+
+    int v1 = dsu_find(&plan->dsu, h->city_1);
+    int v2 = dsu_find(&plan->dsu, h->city_2);
+
+    if (v1 != v2) {
+      build_highway(plan, v1, v2, h);
+    }
+  }
+  plan->stats.edges_scanned += i;
+}
+
+int kruskal_parse(Plan plan, Input in) {
+  Highway h = plan->highways;
+  cost_t last = COST_MIN;
+  int i = 0, sorted = 1;
+
+  for (i = 0; i < plan->n_highways && read_highway(plan, in, h); i++, h++) {
+    if (highways_in_cities(h, 1, plan->n_cities) == 0) {
+      plan->invalid_city = 1;
+      break;
+    }
+    sorted &= h->cost >= last;
+    last = h->cost;
+
+    /* Planning stops once connected, but the order of the rest is still checked */
+    if (sorted && plan->n_components > 1) {
+      int v1 = dsu_find(&plan->dsu, h->city_1);
+      int v2 = dsu_find(&plan->dsu, h->city_2);
+
+      if (v1 != v2) {
+        build_highway(plan, v1, v2, h);
+      }
+      plan->stats.edges_scanned++;
+    }
+  }
+
+  /* A truncated input only holds the highways that were read, and a plan with a
+   * highway out of it is not worth sorting */
+  plan->n_highways = i;
+  return sorted || plan->invalid_city ? 0 : -1;
+}
+
+int kruskal_stream(Plan plan, Input in) {
+  struct highway chunk[STREAM_CHUNK_SIZE];
+  cost_t last = COST_MIN;
+  int64_t i = 0;
+  int k = 0, n_chunk = 0;
+
+  for (i = 0; i < plan->n_streamed && plan->n_components > 1; i++) {
+    Highway h;
+    int v1 = 0, v2 = 0;
+
+    if (k == n_chunk) {
+      n_chunk = stream_highways(plan, in, chunk, plan->n_streamed - i < STREAM_CHUNK_SIZE ? (int) (plan->n_streamed - i) : STREAM_CHUNK_SIZE);
+      k = 0;
+      if (n_chunk == 0) break;
+    }
+    h = &chunk[k++];
+
+    /* Nothing was kept to sort, so highways out of order can not be planned */
+    if (h->cost < last) return -1;
+    last = h->cost;
+
+    v1 = dsu_find(&plan->dsu, h->city_1);
+    v2 = dsu_find(&plan->dsu, h->city_2);
+    if (v1 != v2) {
+      build_highway(plan, v1, v2, h);
+    }
+  }
+
+  plan->stats.edges_scanned += i;
+  return 0;
+}
+
+void filter_kruskal(Plan plan, Highway hs, int n, Pool pool) {
+  int n_light = 0;
+  cost_t pivot = 0, a = 0, b = 0, c = 0;
+
+  if (n <= FILTER_KRUSKAL_THRESHOLD) {
+    sort_highways(hs, n, plan_scratch(plan));
+    kruskal(plan, hs, n);
+    return;
+  }
+
+  /* Median of three as the pivot */
+  a = hs[0].cost;
+  b = hs[n / 2].cost;
+  c = hs[n - 1].cost;
+  pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+  n_light = partition_highways(hs, n, pivot);
+
+  /* The pivot was the largest cost, so the split is retried one cost below it. No
+   * cost is below the smallest one, so every highway then has that cost */
+  if (n_light == n) n_light = pivot > COST_MIN ? partition_highways(hs, n, pivot - 1) : 0;
+
+  /* Every highway has the same cost and so they are already sorted */
+  if (n_light == 0) {
+    kruskal(plan, hs, n);
+    return;
+  }
+
+  filter_kruskal(plan, hs, n_light, pool);
+  if (plan->n_components > 1) {
+    n = n_light + filter_highways(plan, hs + n_light, n - n_light, pool);
+    filter_kruskal(plan, hs + n_light, n - n_light, pool);
+  }
+}
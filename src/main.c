@@ -1,310 +1,248 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "stdlib.h"
 #include "stdio.h"
+#include "string.h"
+#include "unistd.h"
+#include "sys/resource.h"
+
+#include "navyplan.h"
+#include "reader.h"
+#include "writer.h"
 
 
 /* ################################ Globals ################################ */
 
 
 /**
- * @brief Highway configuration that is going to be associated to a city and used
- * in a linked list.
+ * @brief Command line configuration.
  * 
- * @param city_1 city node whose holder can be connected to through a highway
- * @param city_2 other city node whose holder can be connected to through a highway
- * @param cost cost of building this highway
- */
-typedef struct highway {
-  int city_1;
-  int city_2;
-  int cost;
-} *Highway;
-
-/**
- * @brief City configuration that can be turned into a graph.
- * 
- * @param id id of the city
- * @param port_cost cost of building a port (0 if no port can be built)
- * @param capital parent city that is the parent of this one in the MST sub-trees
- * @param n_connected_cities number of connected cities in the MST sub-tree
- */
-typedef struct city {
-  int id;
-  int port_cost;
-  struct city* capital;
-  int n_connected_cities;
-} *City;
-
-/**
- * @brief Holds the number of cities in our graph.
- */
-int n_cities = -1;
-
-/**
- * @brief Number of possible ports that can exist in our graph.
- */
-int n_ports = -1;
-
-/**
- * @brief Number of possible highways that can exist in our graph.
- */
-int n_highways = -1;
-
-/**
- * @brief Holds cities and their configurations.
- */
-City cities;
-
-/**
- * @brief Holds highways that can be built in this city.
- */
-Highway highways;
-
-/**
- * @brief Holds the total cost that has to be paid for the current city plan.
- */
-int total_plan_cost = 0;
-
-/**
- * @brief Holds reference to the first city with a port. Used to connect every port.
+ * @param options configuration of every plan
+ * @param path path of the input file (NULL to use the standard input)
+ * @param batch 1 if the input holds a count followed by that many plans
+ * @param stats 1 to report the timings and counters of the plan on stderr
  */
-City first_city_with_port = NULL;
+struct cli {
+  struct plan_options options;
+  const char *path;
+  int batch;
+  int stats;
+};
 
 
-/* ################################ Helpers ################################ */
+/* ################################# Funcs ################################# */
 
 
 /**
- * @brief Gets index of city in cities array.
+ * @brief Reads the command line options.
  * 
- * @param city city to fetch the location from
- * 
- * @return int index of city
- */
-int ptr_to_loc(City city) {
-  int r;
-  r = -1;
-  if(NULL != city) r = ((size_t) city - (size_t) cities) / sizeof(struct city);
-  return (int) r;
-}
-
-/**
- * @brief Creates highway reference and links it to both cities.
+ * @param argc number of arguments
+ * @param argv arguments of the program
+ * @param cli where the configuration is stored
  * 
- * @param city_1 one of the cities involved in this highway
- * @param city_2 another city in the highway
- * @param cost cost of building the highway
- * @param index index of the highway in the highways object
- */
-void build_highway(int city_1, int city_2, int cost, Highway h) {
-  /* Saves cities identifiers*/
-  h->city_1 = city_1;
-  h->city_2 = city_2;
+ * @return int 0 for success or -1 for an invalid option
+ */
+int parse_options(int argc, char *argv[], struct cli *cli) {
+  int i = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--engine=kruskal") == 0) {
+      cli->options.engine = ENGINE_KRUSKAL;
+    } else if (strcmp(argv[i], "--engine=filter") == 0) {
+      cli->options.engine = ENGINE_FILTER_KRUSKAL;
+    } else if (strcmp(argv[i], "--engine=boruvka") == 0) {
+      cli->options.engine = ENGINE_BORUVKA;
+    } else if (strcmp(argv[i], "--engine=stream") == 0) {
+      cli->options.engine = ENGINE_STREAM;
+    } else if (strcmp(argv[i], "--engine=external") == 0) {
+      cli->options.engine = ENGINE_EXTERNAL;
+    } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+      cli->options.n_threads = atoi(argv[i] + 10);
+    } else if (strncmp(argv[i], "--memory=", 9) == 0) {
+      cli->options.memory = (size_t) atol(argv[i] + 9) << 20;
+    } else if (strcmp(argv[i], "--output=summary") == 0) {
+      cli->options.output = OUTPUT_SUMMARY;
+    } else if (strcmp(argv[i], "--output=full") == 0) {
+      cli->options.output = OUTPUT_FULL;
+    } else if (strcmp(argv[i], "--ports=all") == 0) {
+      cli->options.ports = PORTS_ALL;
+    } else if (strcmp(argv[i], "--ports=optimal") == 0) {
+      cli->options.ports = PORTS_OPTIMAL;
+    } else if (strcmp(argv[i], "--parse=serial") == 0) {
+      cli->options.parse = PARSE_SERIAL;
+    } else if (strcmp(argv[i], "--parse=parallel") == 0) {
+      cli->options.parse = PARSE_PARALLEL;
+    } else if (strcmp(argv[i], "--sorted") == 0) {
+      cli->options.sorted = 1;
+    } else if (strcmp(argv[i], "--batch") == 0) {
+      cli->batch = 1;
+    } else if (strcmp(argv[i], "--stats") == 0) {
+      cli->stats = 1;
+    } else if (argv[i][0] != '-' && NULL == cli->path) {
+      cli->path = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [--engine=kruskal|filter|boruvka|stream|external] [--threads=N] [--memory=MB] [--output=summary|full] [--ports=all|optimal] [--parse=serial|parallel] [--sorted] [--batch] [--stats] [input]\n", argv[0]);
+      return -1;
+    }
+  }
 
-  /* Updates highway cost */
-  h->cost = cost;
+  return 0;
 }
 
 /**
- * @brief Used in qsort to sort all highways.
+ * @brief Reports why a plan could not be solved.
  * 
- * @param h1 highway 1
- * @param h2 highway 2
+ * @param status -1 if the plan could not be loaded, -2 if a cost overflowed, -3
+ * if the highways of a stream were out of order, -4 if the temporary file of the
+ * external engine could not be used, -5 if memory could not be allocated, -6 if
+ * the threads could not be started or -7 if a streamed highway leads to a city out
+ * of the plan
  * 
- * @return int 1 if left is less or -1 if not
- */
-int highway_compare(const Highway h1, const Highway h2) {
-  return h1->cost >= h2->cost ? 1 : -1;
-}
-
-/**
- * @brief Frees all the allocated memory in all nodes.
- */
-void free_program_memory() {
-  free(cities);
-  free(highways);
+ * @return int 1, the exit status of the program
+ */
+int report_failure(int status) {
+  if (status == -2) {
+    fprintf(stderr, "navy: cost overflow, a cost or the plan total does not fit its type\n");
+  } else if (status == -3) {
+    fprintf(stderr, "navy: the stream engine needs highways sorted by cost\n");
+  } else if (status == -4) {
+    fprintf(stderr, "navy: could not use the temporary file of the external engine\n");
+  } else if (status == -5) {
+    fprintf(stderr, "navy: out of memory\n");
+  } else if (status == -6) {
+    fprintf(stderr, "navy: could not start the worker threads\n");
+  } else if (status == -7) {
+    fprintf(stderr, "navy: a highway leads to a city out of the plan\n");
+  } else {
+    fprintf(stderr, "navy: could not load the plan\n");
+  }
+  return 1;
 }
 
-
-/* ############################# MST Algorithm ############################# */
-
-
 /**
- * @brief Checks if these two cities are not in the same sub-tree.
- * 
- * @param c1 one of the cities to check
- * @param c2 other city to check
+ * @brief Reports the timings and counters of a solved plan, along with the peak
+ * resident memory of the process, on stderr as a single line of JSON.
  * 
- * @return int 0 if false and 1 if true
- */
-int cities_are_connected(City c1, City c2) {
-  return c1 == c2 || (c1->port_cost != 0 && c2->port_cost != 0);
+ * @param plan solved plan
+ * @param options configuration of the plan
+ */
+void report_stats(Plan plan, const struct plan_options *options) {
+  static const char *engines[] = {"kruskal", "filter", "boruvka", "stream", "external"};
+  struct plan_stats stats;
+  struct rusage usage;
+
+  plan_get_stats(plan, &stats);
+  if (getrusage(RUSAGE_SELF, &usage) != 0) usage.ru_maxrss = 0;
+  fprintf(stderr,
+    "{\"engine\":\"%s\",\"ports\":\"%s\","
+    "\"seconds\":{\"parse\":%.9f,\"ports\":%.9f,\"sort\":%.9f,\"mst\":%.9f},"
+    "\"counters\":{\"edges_scanned\":%" PRId64 ",\"finds\":%" PRId64
+    ",\"path_length\":%" PRId64 ",\"unions\":%" PRId64 "},\"max_rss_kb\":%ld}\n",
+    options->ports == PORTS_OPTIMAL ? "kruskal" : engines[options->engine],
+    options->ports == PORTS_OPTIMAL ? "optimal" : "all",
+    stats.parse_seconds, stats.ports_seconds, stats.sort_seconds, stats.mst_seconds,
+    stats.edges_scanned, stats.finds, stats.path_length, stats.unions,
+    (long) usage.ru_maxrss);
 }
 
 /**
- * @brief Finds the capital city of another child city in a disjoint set.
+ * @brief Loads a single plan from the input, solves it and prints its outcome.
  * 
- * @param city city to look for the capital
+ * @param options configuration of the plan
+ * @param in input holding the plan
+ * @param out writer to write the outcome to
+ * @param stats 1 to report the timings and counters of the plan on stderr
  * 
- * @return City parent city of this child
+ * @return int 0 for success or 1 for error
  */
-City find(City child) {
-  if (child->capital == child)
-    return child;
-  child->capital = find(child->capital);
-  return child->capital;
-}
+int run_plan(const struct plan_options *options, Input in, Writer out, int stats) {
+  Plan plan = plan_create(options);
+  int status = 0, solved = 0;
 
-/**
- * @brief Perform a union of two disjoint sets. Attaches the smaller rank tree under the root of the higher rank tree
- * 
- * @param x one of the cities to fuse into a single component
- * @param y another city to fuse into a single connected graph
- */
-void union_set(City x, City y) {
-  City x_root = find(x);
-  City y_root = find(y);
+  /* Builds cities configuration */
+  if (NULL == plan || plan_load(plan, in) != 0) {
+    status = -1;
 
-  if (x_root->n_connected_cities < y_root->n_connected_cities) {
-    x_root->capital = y_root;
-  } else if (x_root->n_connected_cities > y_root->n_connected_cities) {
-    y_root->capital = x_root;
+  /* Computes the minimum spanning tree plan of this city and its cost */
+  } else if ((solved = plan_solve(plan)) != 0) {
+    status = solved - 1;
   } else {
-    if (x_root->port_cost != 0) {
-      y_root->capital = x_root;
-      x_root->n_connected_cities++;
-    } else {
-      x_root->capital = y_root;
-      y_root->n_connected_cities++;
-    }
+    plan_write(plan, out);
   }
+
+  if (stats && status != -1) report_stats(plan, options);
+
+  plan_destroy(plan);
+  return status == 0 ? 0 : report_failure(status);
 }
 
 /**
- * @brief Implementation of the kruskal algorithm to compute a minimum
- * spanning tree. Source:
- * https://www.geeksforgeeks.org/kruskals-minimum-spanning-tree-algorithm-greedy-algo-2/
+ * @brief Solves a batch of plans, a count followed by that many plans, printing
+ * their outcomes in input order.
+ * 
+ * @param options configuration of every plan, n_threads being the number of workers
+ * @param in input holding the batch
+ * @param out writer to write the outcomes to
+ * 
+ * @return int 0 for success or 1 for error
  */
-void kruskal() {
-  int 
-    i = 0, 
-    n_components = n_cities - n_ports, 
-    n_highways_used = 0;
-
-  /* If we have ports, we have to add 1 to account for their connection */
-  if (n_ports != 0) {
-    n_components++;
-  }
+int run_batch(const struct plan_options *options, Input in, Writer out) {
+  int n_plans = 0, status = 0;
 
-  /* Loops over all possible highways that can be built to connect the city and chooses the cheapest
-   * for each of the city components that are not yet connected */
-  for (i = 0; i < n_highways && n_components > 1; i++) {
-    Highway h = &highways[i];
+  if (!input_next_int(in, &n_plans)) return 0;
 
-    City v1 = find(&cities[h->city_1]);
-    City v2 = find(&cities[h->city_2]);
-
-    /* If they are from different city components, we should merge them together */
-    if (!cities_are_connected(v1, v2)) {
-      total_plan_cost += h->cost;
-      n_highways_used++;
-      n_components--;
-      union_set(v1, v2);
-    }
-  }
-
-  /* Nothing changed and so, it has finished without connecting all cities */
-  if (n_components > 1) {
-    printf("Impossible\n");
-    return;
-  }
-
-  /* Algorithm finished and all cities are connected */
-  printf("%d\n%d %d\n", total_plan_cost, n_ports, n_highways_used);
+  status = plan_solve_batch(in, n_plans, options, out);
+  return status == 0 ? 0 : report_failure(status);
 }
 
-
-/* ################################# Funcs ################################# */
-
-
 /**
- * @brief Builds cities inital configuration from the standard input.
+ * @brief Main driver code.
+ * 
+ * @param argc number of arguments
+ * @param argv options and optional path of the input file (standard input is used
+ * otherwise)
+ * 
+ * @return int 0 for success or 1 for error
  */
-void build_cities() {
-  int i = 0, cost = 0, city_1 = 0, city_2 = 0;
-
-  /* Reads number of cities and build structure for it */
-  scanf("%d\n", &n_cities);
-  cities = (City) calloc(n_cities + 1, sizeof(struct city));
+int main(int argc, char *argv[]) {
+  struct cli cli;
+  struct writer out;
+  Input in = NULL;
+  int status = 0;
 
-  /* Each city will start off by being connected to itself and having only one connection */
-  for (i = 1; i < n_cities + 1; i++) {
-    cities[i].capital = &cities[i];
-    cities[i].n_connected_cities = 1;
-    cities[i].id = i + 1;
+  memset(&cli, 0, sizeof(cli));
+  if (parse_options(argc, argv, &cli) != 0) {
+    exit(1);
   }
 
-  /* Builds ports using the configuration from standard in */
-  scanf("%d\n", &n_ports);
-  for (i = 0; i < n_ports; i++) {
-    scanf("%d %d", &city_1, &cost);
-    cities[city_1].port_cost = cost;
-    total_plan_cost += cost;
-    first_city_with_port = &cities[city_1];
+  /* Stats can also be turned on from the environment, e.g. NAVY_STATS=1 */
+  if (NULL != getenv("NAVY_STATS") && strcmp(getenv("NAVY_STATS"), "") != 0 && strcmp(getenv("NAVY_STATS"), "0") != 0) {
+    cli.stats = 1;
   }
 
-  /* Reads max number of highways that can be built and builds struct for it */
-  scanf("%d\n", &n_highways);
-  highways = (Highway) calloc(n_highways, sizeof(struct highway));
-
-  /* Inserts highways in the struct and connects them to the cities */
-  for (i = 0, city_1 = 0; i < n_highways; i++) {
-    scanf("%d %d %d\n", &city_1, &city_2, &cost);
-    build_highway(city_1, city_2, cost, &highways[i]);
+  /* Streamed plans are read in chunks, so that they do not have to fit in memory */
+  if ((cli.options.engine == ENGINE_STREAM || cli.options.engine == ENGINE_EXTERNAL) && !cli.batch) {
+    in = input_open_stream(cli.path);
+  } else {
+    in = input_open(cli.path);
   }
-
-  /* Sorts highways to make it faster to loop for them */
-  qsort(highways, n_highways, sizeof(struct highway), (int (*) (const void *, const void *)) &highway_compare);
-}
-
-/**
- * @brief Uses the previously built city and plans the connections between the cities
- * using the ports and the highways and computes the total city cost and counting the 
- * number of ports and highways built.
- */
-void compute_city_plan() {
-  int n_city_components = n_cities - n_ports, i = 0;
-
-  /* Fixes number of city components in the case that there is no ports */
-  if (n_ports != 0) {
-    n_city_components++;
+  if (NULL == in || writer_init_fd(&out, STDOUT_FILENO) != 0) {
+    perror("navy");
+    exit(1);
   }
 
-  /* Pre connects all ports to form a single component */
-  for (i = 0; i < n_cities && first_city_with_port != NULL; i++) {
-    if (cities[i].port_cost != 0) {
-      union_set(first_city_with_port, &cities[i]);
-    }
+  if (cli.batch) {
+    status = run_batch(&cli.options, in, &out);
+  } else {
+    status = run_plan(&cli.options, in, &out, cli.stats);
   }
 
-  /* Plans city with kruskal algorithm */
-  kruskal();
-}
-
-/**
- * @brief Main driver code.
- * 
- * @return int 0 for success or 1 for error
- */
-int main() {
-
-  /* Builds cities configuration */
-  build_cities();
-
-  /* Computes the minimum spanning tree plan of this city and its cost */
-  compute_city_plan();
-
   /* Cleans up the program by freeing all the allocated memory */
-  free_program_memory();
+  if (writer_close(&out) != 0) {
+    perror("navy");
+    status = 1;
+  }
+  input_close(in);
 
-  exit(0);
+  exit(status);
 }
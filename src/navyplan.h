@@ -0,0 +1,256 @@
+#ifndef NAVYPLAN_H
+#define NAVYPLAN_H
+
+#include "stdio.h"
+
+#include "highway.h"
+#include "pool.h"
+#include "reader.h"
+#include "writer.h"
+
+
+/* ################################ Options ################################ */
+
+
+/**
+ * @brief Algorithms that can be used to compute the minimum spanning tree.
+ * ENGINE_STREAM is Kruskal over highways that are already sorted, planning them as
+ * they are read from the input without ever storing them, and it stops reading as
+ * soon as every city is connected. Open the input with input_open_stream() to keep
+ * memory proportional to the number of cities. ENGINE_EXTERNAL does the same for
+ * unsorted highways, sorting runs of them into a temporary file ($TMPDIR or /tmp)
+ * and merging the runs as they are planned.
+ */
+enum engine {
+  ENGINE_KRUSKAL,
+  ENGINE_FILTER_KRUSKAL,
+  ENGINE_BORUVKA,
+  ENGINE_STREAM,
+  ENGINE_EXTERNAL
+};
+
+/**
+ * @brief What is printed for a solved plan.
+ */
+enum output {
+  OUTPUT_SUMMARY,
+  OUTPUT_FULL
+};
+
+/**
+ * @brief Which ports are built.
+ */
+enum ports {
+  PORTS_ALL,
+  PORTS_OPTIMAL
+};
+
+/**
+ * @brief How the highways of text plans are read. PARSE_PARALLEL splits them between
+ * the threads of the plan when the whole input is in memory and the plan is big
+ * enough for it to pay off, and reads them serially otherwise.
+ */
+enum parse {
+  PARSE_SERIAL,
+  PARSE_PARALLEL
+};
+
+/**
+ * @brief Configuration of a plan.
+ *
+ * @param engine algorithm used to plan the city
+ * @param n_threads number of threads used by parallel engines and the parallel parser
+ * (0 uses every online processor)
+ * @param pool worker threads shared between plans, which may be solved at the same
+ * time from several threads: their parallel steps then queue for the pool (NULL to
+ * let each plan start its own when a parallel engine needs them)
+ * @param output OUTPUT_SUMMARY prints the cost and counts, OUTPUT_FULL also lists
+ * every port and every highway built, in the order they were picked
+ * @param ports PORTS_ALL builds every port, PORTS_OPTIMAL builds only the ports that
+ * make the plan cheaper (possibly none), always planning with a sorted Kruskal pass
+ * @param sorted 1 if the highways of the input are sorted by increasing cost, which
+ * is checked as they are used. With the kruskal engine and every port built, the
+ * highways of text plans are then read by plan_solve() and planned as they are
+ * read, so the input must stay open until the plan is solved
+ * @param memory bytes the external engine may use to sort each run of highways (0
+ * for 1GB)
+ * @param parse PARSE_SERIAL or PARSE_PARALLEL
+ */
+struct plan_options {
+  enum engine engine;
+  int n_threads;
+  Pool pool;
+  enum output output;
+  enum ports ports;
+  int sorted;
+  size_t memory;
+  enum parse parse;
+};
+
+/**
+ * @brief Outcome of a solved plan.
+ *
+ * @param connected 1 if every city could be connected and 0 if the plan is impossible
+ * @param total_plan_cost total cost of the ports and highways that are built
+ * @param n_ports number of ports that are built
+ * @param n_highways_used number of highways that are built
+ */
+struct plan_result {
+  int connected;
+  plan_cost_t total_plan_cost;
+  int n_ports;
+  int n_highways_used;
+};
+
+/**
+ * @brief Where the time of the last plan loaded and solved went. Phases are timed
+ * with a monotonic clock; engines that sort as they go (filter, boruvka) count
+ * their sorting as part of the spanning tree.
+ *
+ * @param parse_seconds time spent reading the plan
+ * @param ports_seconds time spent building the ports
+ * @param sort_seconds time spent sorting the highways
+ * @param mst_seconds time spent computing the minimum spanning tree
+ * @param edges_scanned highways looked at before the plan was connected or there
+ * were none left
+ * @param finds number of finds on the disjoint sets of cities
+ * @param path_length number of parents walked by those finds
+ * @param unions number of unions of city components
+ */
+struct plan_stats {
+  double parse_seconds;
+  double ports_seconds;
+  double sort_seconds;
+  double mst_seconds;
+  int64_t edges_scanned;
+  int64_t finds;
+  int64_t path_length;
+  int64_t unions;
+};
+
+/**
+ * @brief Planning context. Holds every city, port and highway of a network along
+ * with the state of its minimum spanning tree, so that several networks can be
+ * planned in one process or on several threads at once.
+ */
+typedef struct plan *Plan;
+
+
+/* ################################# Funcs ################################# */
+
+
+/**
+ * @brief Creates an empty plan.
+ *
+ * @param options configuration of the plan (NULL for the defaults)
+ *
+ * @return Plan created plan or NULL if it could not be allocated
+ */
+Plan plan_create(const struct plan_options *options);
+
+/**
+ * @brief Builds cities inital configuration from an input in the text or the binary
+ * format, told apart by the magic number binary plans start with. A plan can be
+ * loaded again once solved, reusing the buffers of the previous network.
+ *
+ * @param plan plan to load the network into
+ * @param in input holding the network
+ *
+ * @return int 0 for success or -1 if the input holds no plan, a port or a highway
+ * leads to a city out of the plan, or it could not be allocated
+ */
+int plan_load(Plan plan, Input in);
+
+/**
+ * @brief Plans the connections between the cities using the ports and the highways
+ * and computes the total cost and the number of ports and highways built.
+ *
+ * @param plan loaded plan
+ *
+ * @return int 0 for success, -1 if a cost overflowed, -2 if the stream engine
+ * read a highway that was out of order, -3 if the external engine could not use
+ * its temporary file, -4 if memory could not be allocated, -5 if the threads
+ * could not be started or -6 if a highway read while solving (sorted, streamed or
+ * external plans) leads to a city out of the plan
+ */
+int plan_solve(Plan plan);
+
+/**
+ * @brief Gets the outcome of a solved plan.
+ *
+ * @param plan solved plan
+ * @param result where the outcome is stored
+ */
+void plan_get_result(Plan plan, struct plan_result *result);
+
+/**
+ * @brief Gets the timings and counters of the last plan loaded and solved.
+ *
+ * @param plan solved plan
+ * @param stats where the timings and counters are stored
+ */
+void plan_get_stats(Plan plan, struct plan_stats *stats);
+
+/**
+ * @brief Writes the outcome of a solved plan in the output format of the program.
+ * The summary is the total cost followed by the number of ports and highways built
+ * (or Impossible). The full output then lists a "P city cost" line for every port
+ * and a "H city_1 city_2 cost" line for every highway built, in pick order.
+ *
+ * @param plan solved plan
+ * @param w writer to write to
+ */
+void plan_write(Plan plan, Writer w);
+
+/**
+ * @brief Prints the outcome of a solved plan, as plan_write does, to a stream.
+ *
+ * @param plan solved plan
+ * @param out stream to print to
+ */
+void plan_print(Plan plan, FILE *out);
+
+/**
+ * @brief Writes a loaded plan in the binary format (see binary.h), whose highways
+ * are loaded in place without any parsing.
+ *
+ * @param plan loaded plan, not yet solved
+ * @param w writer to write to
+ * @param sort 1 to sort the highways by cost first and flag them as sorted
+ *
+ * @return int 0 for success or -1 if the sort buffer could not be allocated or the
+ * plan could not be written
+ */
+int plan_save(Plan plan, Writer w, int sort);
+
+/**
+ * @brief Solves a batch of plans on a pool of workers, each one with its own plan
+ * context that is reused for every plan it solves. Plans are split in contiguous
+ * runs between the workers and idle workers steal plans from the others, while the
+ * outcomes are still printed in input order. Workers read their plans straight
+ * from where they start in the input, so only an input held whole in memory (a
+ * mapped file or a buffer, fd < 0) is split between them: a streamed input is
+ * solved one plan after the other.
+ *
+ * @param in input positioned at the first plan of the batch
+ * @param n_plans number of plans in the batch
+ * @param options configuration of every plan, n_threads being the number of workers
+ * (plans themselves run single-threaded)
+ * @param out writer to write the outcomes to
+ *
+ * @return int 0 for success or, for the first plan that failed, -1 if it could not
+ * be loaded or the status of plan_solve() minus one (-2 if a cost overflowed, -3
+ * if a highway was out of order, ...), in which case the outcomes of the plans
+ * before it are written. -5 is also returned if memory could not be allocated and
+ * -6 if the workers could not be started
+ */
+int plan_solve_batch(Input in, int n_plans, const struct plan_options *options, Writer out);
+
+/**
+ * @brief Frees a plan and everything it holds.
+ *
+ * @param plan plan to destroy
+ */
+void plan_destroy(Plan plan);
+
+#endif
@@ -0,0 +1,152 @@
+#include "limits.h"
+#include "stdlib.h"
+#include "string.h"
+
+#include "plan.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Highways of a text plan shared by the threads parsing them.
+ *
+ * @param plan plan being loaded
+ * @param start first byte of the chunk of every thread, followed by the end of the
+ * input
+ * @param first index of the first number of the chunk of every thread among the
+ * numbers of the highways, followed by the count of all of them
+ * @param n_highways number of highways to read
+ * @param cursor where the input continues after the last highway
+ * @param overflow set when a thread read a cost that overflowed
+ * @param invalid set when a thread read a highway leading to a city out of the plan
+ */
+struct parse_chunks {
+  Plan plan;
+  const char **start;
+  long *first;
+  long n_highways;
+  const char *cursor;
+  int *overflow;
+  int *invalid;
+};
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Sets an input to scan a part of a whole input.
+ *
+ * @param in input to set
+ * @param start first byte to scan
+ * @param end one past the last byte to scan
+ */
+static void parse_input(Input in, const char *start, const char *end) {
+  memset(in, 0, sizeof(*in));
+  in->data = in->cursor = start;
+  in->end = end;
+  in->fd = -1;
+  in->eof = 1;
+}
+
+/**
+ * @brief Counts the numbers of the chunk of a thread.
+ *
+ * @param arg struct parse_chunks being filled
+ * @param thread index of the thread and of its chunk
+ * @param n_threads number of threads (unused)
+ */
+static void parse_count(void *arg, int thread, int n_threads) {
+  struct parse_chunks *parse = arg;
+  struct input in;
+
+  (void) n_threads;
+  parse_input(&in, parse->start[thread], parse->start[thread + 1]);
+  parse->first[thread + 1] = input_skip_ints(&in, LONG_MAX);
+}
+
+/**
+ * @brief Parses the highways that start in the chunk of a thread. The first numbers
+ * of a chunk may belong to a highway of the previous one, and the last highway of a
+ * chunk may end in the next one, so chunks are scanned up to the end of the input.
+ *
+ * @param arg struct parse_chunks with the numbers of every chunk counted
+ * @param thread index of the thread and of its chunk
+ * @param n_threads number of threads (unused)
+ */
+static void parse_chunk(void *arg, int thread, int n_threads) {
+  struct parse_chunks *parse = arg;
+  long begin = (parse->first[thread] + 2) / 3, end = (parse->first[thread + 1] + 2) / 3;
+  Highway hs = parse->plan->highways;
+  struct input in;
+  int n = 0;
+
+  (void) n_threads;
+  if (end > parse->n_highways) end = parse->n_highways;
+  if (begin >= end) return;
+
+  parse_input(&in, parse->start[thread], parse->start[n_threads]);
+  input_skip_ints(&in, 3 * begin - parse->first[thread]);
+  n = scan_highways(&in, hs + begin, (int) (end - begin), &parse->overflow[thread]);
+  parse->invalid[thread] = highways_in_cities(hs + begin, n, parse->plan->n_cities) < n;
+
+  if (end == parse->n_highways) parse->cursor = in.cursor;
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+int parse_highways_parallel(Plan plan, Input in, Pool pool) {
+  struct parse_chunks parse;
+  int n_threads = pool_size(pool), t = 0;
+  long length = in->end - in->cursor;
+
+  memset(&parse, 0, sizeof(parse));
+  parse.plan = plan;
+  parse.start = malloc((n_threads + 1) * sizeof(const char *));
+  parse.first = calloc(n_threads + 1, sizeof(long));
+  parse.overflow = calloc(n_threads, sizeof(int));
+  parse.invalid = calloc(n_threads, sizeof(int));
+  if (NULL == parse.start || NULL == parse.first || NULL == parse.overflow || NULL == parse.invalid) {
+    free(parse.start);
+    free(parse.first);
+    free(parse.overflow);
+    free(parse.invalid);
+    return -1;
+  }
+
+  /* Chunks start right after a newline, so that no number is split between two */
+  parse.start[0] = in->cursor;
+  for (t = 1; t < n_threads; t++) {
+    const char *p = in->cursor + length / n_threads * t;
+    const char *newline = NULL;
+
+    if (p < parse.start[t - 1]) p = parse.start[t - 1];
+    newline = memchr(p, '\n', in->end - p);
+    parse.start[t] = NULL != newline ? newline + 1 : in->end;
+  }
+  parse.start[n_threads] = in->end;
+  pool_run(pool, parse_count, &parse);
+
+  /* Only whole highways are read, as the serial reader does */
+  for (t = 0; t < n_threads; t++) {
+    parse.first[t + 1] += parse.first[t];
+  }
+  parse.n_highways = parse.first[n_threads] / 3;
+  if (parse.n_highways > plan->n_highways) parse.n_highways = plan->n_highways;
+  parse.cursor = in->cursor;
+  pool_run(pool, parse_chunk, &parse);
+
+  for (t = 0; t < n_threads; t++) {
+    plan->cost_overflow |= parse.overflow[t];
+    plan->invalid_city |= parse.invalid[t];
+  }
+  in->cursor = parse.cursor;
+  free(parse.start);
+  free(parse.first);
+  free(parse.overflow);
+  free(parse.invalid);
+  return (int) parse.n_highways;
+}
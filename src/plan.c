@@ -0,0 +1,698 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdlib.h"
+#include "string.h"
+#include "limits.h"
+#include "time.h"
+
+#include "binary.h"
+#include "plan.h"
+#include "sort.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Below this number of highways splitting them between threads costs more
+ * than parsing them serially.
+ */
+#define PARSE_PARALLEL_THRESHOLD (1 << 16)
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Perform a union of two disjoint sets. Attaches the smaller tree under the
+ * capital of the bigger tree.
+ * 
+ * @param plan plan being solved
+ * @param x one of the cities to fuse into a single component
+ * @param y another city to fuse into a single connected graph
+ * 
+ * @return int 1 if they were in different sets and 0 if not
+ */
+static int union_set(Plan plan, int x, int y) {
+  int x_root = dsu_find(&plan->dsu, x);
+  int y_root = dsu_find(&plan->dsu, y);
+
+  if (x_root == y_root) return 0;
+
+  dsu_link(&plan->dsu, x_root, y_root);
+  return 1;
+}
+
+/**
+ * @brief Builds every port and pre connects them to form a single component, as
+ * every port is joined by the sea.
+ * 
+ * @param plan plan being solved, with a fresh disjoint set
+ */
+static void plan_connect_ports(Plan plan) {
+  int i = 0;
+
+  plan->n_components = plan->n_cities - plan->n_ports;
+  if (plan->n_ports != 0) {
+    plan->n_components++;
+  }
+
+  plan->n_ports_built = plan->n_ports;
+  for (i = 1; i <= plan->n_cities && plan->first_city_with_port != 0; i++) {
+    if (plan->port_costs[i] != 0) {
+      add_plan_cost(plan, plan->port_costs[i]);
+      union_set(plan, plan->first_city_with_port, i);
+    }
+  }
+}
+
+/**
+ * @brief Gets the threads the highways of a plan are sorted on, which are only
+ * started for plans big enough to sort in parallel.
+ * 
+ * @param plan plan being solved
+ * 
+ * @return Pool threads of the plan or NULL to sort serially
+ */
+static Pool plan_sort_pool(Plan plan) {
+  if (plan->n_highways < PARALLEL_SORT_THRESHOLD || plan->options.n_threads == 1) return NULL;
+  return plan_pool(plan);
+}
+
+/**
+ * @brief Gets the threads Filter-Kruskal runs its large filter steps on. Plans too
+ * small for a single parallel filter step are filtered serially, and so are those
+ * of a single thread or whose threads could not be started.
+ * 
+ * @param plan plan being solved
+ * 
+ * @return Pool threads to filter on or NULL to filter serially
+ */
+static Pool plan_filter_pool(Plan plan) {
+  if (plan->n_highways < PARALLEL_FILTER_THRESHOLD || plan->options.n_threads == 1) return NULL;
+  return plan_pool(plan);
+}
+
+/**
+ * @brief Packs the highways into the narrow layout and sorts them, when the plan
+ * fits it. Sorted plans are left alone, as kruskal may stop long before reaching
+ * the end of them, and so are tiny ones, which are not worth packing.
+ * 
+ * @param plan plan being solved
+ * 
+ * @return NarrowHighway the sorted narrow highways or NULL if the plan is left in
+ * the wide layout
+ */
+static NarrowHighway plan_sort_narrow(Plan plan) {
+  NarrowHighway hs = NULL;
+
+  if (plan->sorted || plan->n_highways < RADIX_SORT_THRESHOLD) return NULL;
+  if (!highways_fit_narrow(plan->highways, plan->n_highways, plan->n_cities)) return NULL;
+  if (NULL == plan_scratch(plan)) return NULL;
+
+  hs = pack_narrow_highways(plan->highways, plan->n_highways);
+  sort_narrow_highways_parallel(hs, plan->n_highways, (NarrowHighway) plan->scratch, plan_sort_pool(plan));
+  return hs;
+}
+
+/**
+ * @brief Sorts the highways as packed keys, when they are wide enough for it to pay
+ * off and their costs fit the keys. Sorted and tiny plans are left alone, as for
+ * plan_sort_narrow(), and so are plans sorted in parallel, as the key sort is
+ * serial.
+ * 
+ * @param plan plan being solved
+ * 
+ * @return uint64_t* the sorted keys or NULL if the highways are to be sorted in
+ * place
+ */
+static uint64_t *plan_sort_keys(Plan plan) {
+  uint64_t *keys = NULL;
+
+  if (plan->sorted || plan->n_highways < RADIX_SORT_THRESHOLD) return NULL;
+  if (sizeof(struct highway) < KEY_SORT_MIN_HIGHWAY_SIZE) return NULL;
+  if (NULL != plan_sort_pool(plan) && pool_size(plan->pool) > 1) return NULL;
+  if (!highways_fit_keys(plan->highways, plan->n_highways)) return NULL;
+  if (NULL == (keys = plan_keys(plan))) return NULL;
+
+  sort_highway_keys(plan->highways, plan->n_highways, keys, keys + plan->n_highways);
+  return keys;
+}
+
+/**
+ * @brief Frees the network held by a plan.
+ * 
+ * @param plan plan to clear
+ */
+static void plan_free_network(Plan plan) {
+  free(plan->port_costs);
+  free(plan->highways_buffer);
+  free(plan->scratch);
+  free(plan->keys);
+  free(plan->picks);
+  dsu_free(&plan->dsu);
+  plan->port_costs = NULL;
+  plan->highways = plan->highways_buffer = NULL;
+  plan->scratch = NULL;
+  plan->keys = NULL;
+  plan->picks = NULL;
+  plan->cities_capacity = plan->highways_capacity = plan->scratch_capacity = plan->keys_capacity = 0;
+  plan->picks_capacity = 0;
+}
+
+/**
+ * @brief Makes room for the cities of a plan, reusing the buffers of the previous
+ * plan loaded into the same context when they are big enough.
+ * 
+ * @param plan plan being loaded
+ * 
+ * @return int 0 for success or -1 if it could not be allocated
+ */
+static int plan_reserve_cities(Plan plan) {
+  int n = plan->n_cities + 1;
+
+  if (n > plan->cities_capacity) {
+    free(plan->port_costs);
+    plan->port_costs = malloc(n * sizeof(cost_t));
+    plan->cities_capacity = NULL != plan->port_costs ? n : 0;
+    if (NULL == plan->port_costs) return -1;
+  }
+  memset(plan->port_costs, 0, n * sizeof(cost_t));
+
+  /* A spanning tree never has more highways than cities, and optimal ports keep the
+   * picks of the plan with the sea and of the one without it side by side */
+  if (plan->options.ports == PORTS_OPTIMAL) n *= 2;
+  if (plan->options.output == OUTPUT_FULL && n > plan->picks_capacity) {
+    free(plan->picks);
+    plan->picks = malloc(n * sizeof(struct highway));
+    plan->picks_capacity = NULL != plan->picks ? n : 0;
+    if (NULL == plan->picks) return -1;
+  }
+  n = plan->n_cities + 1;
+
+  /* Each city will start off by being connected to itself and having only one connection */
+  return dsu_init(&plan->dsu, n);
+}
+
+/**
+ * @brief Makes room for the highways of a plan, reusing the buffers of the previous
+ * plan loaded into the same context when they are big enough.
+ * 
+ * @param plan plan being loaded
+ * 
+ * @return int 0 for success or -1 if it could not be allocated
+ */
+static int plan_reserve_highways(Plan plan) {
+  int n = plan->n_highways;
+
+  if (n > plan->highways_capacity) {
+    free(plan->highways_buffer);
+    plan->highways_buffer = malloc(n * sizeof(struct highway));
+    plan->highways_capacity = NULL != plan->highways_buffer ? n : 0;
+    if (NULL == plan->highways_buffer) return -1;
+  }
+
+  plan->highways = plan->highways_buffer;
+  return 0;
+}
+
+/**
+ * @brief Checks whether the input continues with a binary plan.
+ * 
+ * @param in input to check
+ * 
+ * @return int 1 if a binary plan header follows and 0 if not
+ */
+static int plan_is_binary(Input in) {
+  if (in->end - in->cursor < (long) sizeof(struct plan_header) && !in->eof) input_refill(in);
+  return in->end - in->cursor >= (long) sizeof(struct plan_header) && memcmp(in->cursor, PLAN_MAGIC, 4) == 0;
+}
+
+/**
+ * @brief Checks the header of a binary plan.
+ * 
+ * @param header header to check
+ * 
+ * @return int 1 if it is valid and 0 if it is not or does not match the cost width
+ * of the build
+ */
+static int plan_header_is_valid(const struct plan_header *header) {
+#ifdef COST_64
+  uint16_t flags = PLAN_COST_64;
+#else
+  uint16_t flags = 0;
+#endif
+
+  if (header->version != PLAN_VERSION || (header->flags & PLAN_COST_64) != flags) return 0;
+  return header->n_cities >= 0 && header->n_ports >= 0 && header->n_highways >= 0;
+}
+
+/**
+ * @brief Checks the header of a binary plan and computes the size of its arrays.
+ * 
+ * @param in input positioned at a binary plan
+ * @param header where the header is copied
+ * 
+ * @return long size of the plan in bytes, header included, or -1 if the header is
+ * invalid or the input is too short
+ */
+static long plan_binary_size(Input in, struct plan_header *header) {
+  long size = 0;
+
+  memcpy(header, in->cursor, sizeof(*header));
+  if (!plan_header_is_valid(header)) return -1;
+
+  size = (long) sizeof(*header) + header->n_ports * (long) sizeof(struct plan_port) +
+    header->n_highways * (long) sizeof(struct highway);
+  return size <= in->end - in->cursor ? size : -1;
+}
+
+/**
+ * @brief Checks whether the highways of the plan are left in the input for the
+ * stream or external engine to read when solving.
+ * 
+ * @param plan plan being loaded
+ * 
+ * @return int 1 if they are streamed and 0 if they are loaded
+ */
+static int plan_streams(Plan plan) {
+  return (plan->options.engine == ENGINE_STREAM || plan->options.engine == ENGINE_EXTERNAL) &&
+    plan->options.ports == PORTS_ALL;
+}
+
+/**
+ * @brief Builds cities inital configuration from a binary plan. When the whole
+ * input is in memory its highways are not copied: the plan uses the highways of the
+ * input in place when they are aligned.
+ * 
+ * @param plan plan to load the network into
+ * @param in input positioned at a binary plan
+ * 
+ * @return int 0 for success or -1 if the plan is invalid, a port or a loaded
+ * highway leading to a city out of the plan, or could not be allocated
+ */
+static int plan_load_binary(Plan plan, Input in) {
+  struct plan_header header;
+  struct plan_port port;
+  long size = 0;
+  int i = 0;
+
+  if (input_read_bytes(in, &header, sizeof(header)) != sizeof(header) || !plan_header_is_valid(&header)) return -1;
+
+  plan->n_cities = header.n_cities;
+  plan->n_ports = header.n_ports;
+  plan->n_highways = header.n_highways;
+  plan->sorted = (header.flags & PLAN_SORTED) != 0;
+  plan->binary = 1;
+  if (plan_reserve_cities(plan) != 0) return -1;
+
+  for (i = 0; i < plan->n_ports; i++) {
+    if (input_read_bytes(in, &port, sizeof(port)) != sizeof(port)) return -1;
+    if (port.city < 1 || port.city > plan->n_cities) return -1;
+    plan->port_costs[port.city] = port.cost;
+    plan->first_city_with_port = port.city;
+  }
+
+  if (plan_streams(plan)) {
+    plan->n_streamed = plan->n_highways;
+    plan->pending = in;
+    return 0;
+  }
+
+  /* The input is a private mapping or buffer, so the engines may reorder it. Plans
+   * that do not start on an aligned address (after a text batch count) are copied */
+  size = plan->n_highways * (long) sizeof(struct highway);
+  if (in->fd < 0 && size <= in->end - in->cursor && (uintptr_t) in->cursor % sizeof(cost_t) == 0) {
+    plan->highways = (Highway) in->cursor;
+    in->cursor += size;
+  } else {
+    if (plan_reserve_highways(plan) != 0) return -1;
+    if (input_read_bytes(in, plan->highways, size) != size) return -1;
+  }
+
+  /* Highways are used as they are, so a city out of the plan would index the
+   * disjoint set out of bounds */
+  return highways_in_cities(plan->highways, plan->n_highways, plan->n_cities) == plan->n_highways ? 0 : -1;
+}
+
+int plan_skip(Input in) {
+  int n_cities = 0, n_ports = 0, n_highways = 0;
+  struct plan_header header;
+  long size = 0;
+
+  if (plan_is_binary(in)) {
+    size = plan_binary_size(in, &header);
+    in->cursor = size < 0 ? in->end : in->cursor + size;
+    return size < 0 ? -1 : 0;
+  }
+
+  if (!input_next_int(in, &n_cities)) return -1;
+  if (input_next_int(in, &n_ports)) input_skip_ints(in, 2L * n_ports);
+  if (input_next_int(in, &n_highways)) input_skip_ints(in, 3L * n_highways);
+  return 0;
+}
+
+double plan_clock(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double) now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int highways_in_cities(const struct highway *hs, int n, int n_cities) {
+  int i = 0;
+
+  /* Unsigned comparisons also catch negative cities */
+  for (i = 0; i < n; i++) {
+    if ((unsigned) hs[i].city_1 - 1 >= (unsigned) n_cities || (unsigned) hs[i].city_2 - 1 >= (unsigned) n_cities) break;
+  }
+
+  return i;
+}
+
+Highway plan_scratch(Plan plan) {
+  if (plan->scratch_capacity < plan->n_highways) {
+    free(plan->scratch);
+    plan->scratch = malloc(plan->n_highways * sizeof(struct highway));
+    plan->scratch_capacity = NULL != plan->scratch ? plan->n_highways : 0;
+  }
+  return plan->scratch;
+}
+
+Pool plan_pool(Plan plan) {
+  if (NULL == plan->pool) {
+    plan->pool = plan->options.pool;
+  }
+  if (NULL == plan->pool) {
+    int n_threads = plan->options.n_threads;
+    plan->pool = pool_create(n_threads > 0 ? n_threads : pool_default_size());
+    plan->owns_pool = 1;
+  }
+  return plan->pool;
+}
+
+uint64_t *plan_keys(Plan plan) {
+  if (plan->keys_capacity < plan->n_highways) {
+    free(plan->keys);
+    plan->keys = malloc(2 * (size_t) plan->n_highways * sizeof(uint64_t));
+    plan->keys_capacity = NULL != plan->keys ? plan->n_highways : 0;
+  }
+  return plan->keys;
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+Plan plan_create(const struct plan_options *options) {
+  Plan plan = calloc(1, sizeof(struct plan));
+
+  if (NULL == plan) return NULL;
+
+  if (NULL != options) plan->options = *options;
+  plan->n_cities = plan->n_ports = plan->n_highways = -1;
+  return plan;
+}
+
+int plan_load(Plan plan, Input in) {
+  int i = 0, city_1 = 0, status = 0;
+  int64_t n_highways = 0;
+  cost_t cost = 0;
+  double start = plan_clock();
+
+  memset(&plan->stats, 0, sizeof(plan->stats));
+  plan->total_plan_cost = 0;
+  plan->cost_overflow = 0;
+  plan->first_city_with_port = 0;
+  plan->n_highways_used = 0;
+  plan->sorted = 0;
+  plan->binary = 0;
+  plan->pending = NULL;
+  plan->invalid_city = 0;
+
+  if (plan_is_binary(in)) {
+    status = plan_load_binary(plan, in);
+    plan->sorted |= plan->options.sorted;
+    plan->stats.parse_seconds = plan_clock() - start;
+    return status;
+  }
+
+  /* Reads number of cities and build structure for it */
+  if (!input_next_int(in, &plan->n_cities) || plan->n_cities < 0) return -1;
+  if (plan_reserve_cities(plan) != 0) return -1;
+
+  /* Builds ports using the configuration from the input */
+  if (!input_next_int(in, &plan->n_ports)) plan->n_ports = 0;
+  for (i = 0; i < plan->n_ports; i++) {
+    if (!input_next_int(in, &city_1) || !read_cost(plan, in, &cost)) break;
+    if (city_1 < 1 || city_1 > plan->n_cities) return -1;
+    plan->port_costs[city_1] = cost;
+    plan->first_city_with_port = city_1;
+  }
+
+  /* Reads max number of highways that can be built and builds struct for it */
+  if (!input_next_int64(in, &n_highways) || n_highways < 0) n_highways = 0;
+
+  /* The stream and external engines read the highways when solving, never storing
+   * all of them, so only they can go past INT_MAX highways */
+  if (plan_streams(plan)) {
+    plan->n_streamed = n_highways;
+    plan->pending = in;
+    plan->stats.parse_seconds = plan_clock() - start;
+    return 0;
+  }
+
+  if (n_highways > INT_MAX) return -1;
+  plan->n_highways = (int) n_highways;
+  if (plan_reserve_highways(plan) != 0) return -1;
+  plan->sorted = plan->options.sorted;
+
+  /* Sorted highways are planned by kruskal as they are read, when solving */
+  if (plan->sorted && plan->options.engine == ENGINE_KRUSKAL && plan->options.ports == PORTS_ALL) {
+    plan->pending = in;
+    plan->stats.parse_seconds = plan_clock() - start;
+    return 0;
+  }
+
+  /* Big plans read whole can be split between threads, each parsing its own slice.
+   * Without threads to split them between, they are parsed serially */
+  if (plan->options.parse == PARSE_PARALLEL && in->fd < 0 && plan->n_highways >= PARSE_PARALLEL_THRESHOLD) {
+    i = NULL != plan_pool(plan) && pool_size(plan->pool) > 1 ? parse_highways_parallel(plan, in, plan->pool) : -1;
+    if (i >= 0) {
+      plan->n_highways = i;
+      plan->stats.parse_seconds = plan_clock() - start;
+      return plan->invalid_city ? -1 : 0;
+    }
+  }
+
+  /* Inserts highways in the struct, a truncated input only holding those read */
+  plan->n_highways = scan_highways(in, plan->highways, plan->n_highways, &plan->cost_overflow);
+  plan->stats.parse_seconds = plan_clock() - start;
+  return highways_in_cities(plan->highways, plan->n_highways, plan->n_cities) == plan->n_highways ? 0 : -1;
+}
+
+int plan_solve(Plan plan) {
+  Input pending = plan->pending;
+  NarrowHighway narrow = NULL;
+  uint64_t *keys = NULL;
+  double start = plan_clock(), sorted = 0;
+
+  /* Highways declared sorted are checked, a wrong declaration only costs a sort */
+  plan->pending = NULL;
+  if (NULL == pending && plan->sorted && !highways_are_sorted(plan->highways, plan->n_highways)) {
+    plan->sorted = 0;
+  }
+
+  if (plan->options.ports == PORTS_OPTIMAL) {
+    if (kruskal_optimal_ports(plan) != 0) return -4;
+    return plan->cost_overflow ? -1 : 0;
+  }
+
+  plan_connect_ports(plan);
+  sorted = plan_clock();
+  plan->stats.ports_seconds = sorted - start;
+  start = sorted;
+
+  /* Plans city with the chosen minimum spanning tree algorithm */
+  switch (plan->options.engine) {
+    case ENGINE_FILTER_KRUSKAL:
+      if (plan->sorted) {
+        kruskal(plan, plan->highways, plan->n_highways);
+      } else {
+        filter_kruskal(plan, plan->highways, plan->n_highways, plan_filter_pool(plan));
+      }
+      break;
+    case ENGINE_BORUVKA:
+      if (NULL == plan_pool(plan)) return -5;
+      if (boruvka(plan) != 0) return -4;
+      break;
+    case ENGINE_STREAM:
+      if (NULL != pending) {
+        if (kruskal_stream(plan, pending) != 0) return -2;
+        break;
+      }
+      /* falls through */
+    case ENGINE_EXTERNAL:
+      if (NULL != pending) {
+        if (kruskal_external(plan, pending) != 0) return -3;
+        break;
+      }
+      /* falls through */
+    default:
+      if (NULL != pending && kruskal_parse(plan, pending) == 0) break;
+
+      /* A highway came out of order, so the plan starts over from the ports */
+      if (NULL != pending) {
+        plan->total_plan_cost = 0;
+        plan->n_highways_used = 0;
+        plan->sorted = 0;
+        dsu_init(&plan->dsu, plan->n_cities + 1);
+        plan_connect_ports(plan);
+      }
+
+      /* Sorts highways to make it faster to loop for them, in the narrow layout for
+       * regional plans so that sorting and scanning move fewer bytes */
+      narrow = plan_sort_narrow(plan);
+      keys = NULL == narrow ? plan_sort_keys(plan) : NULL;
+      if (NULL == narrow && NULL == keys && !plan->sorted) {
+        sort_highways_parallel(plan->highways, plan->n_highways, plan_scratch(plan), plan_sort_pool(plan));
+      }
+      sorted = plan_clock();
+      plan->stats.sort_seconds = sorted - start;
+      start = sorted;
+      if (NULL != narrow) {
+        kruskal_narrow(plan, narrow, plan->n_highways);
+      } else if (NULL != keys) {
+        kruskal_keys(plan, plan->highways, keys, plan->n_highways);
+      } else {
+        kruskal(plan, plan->highways, plan->n_highways);
+      }
+  }
+  plan->stats.mst_seconds = plan_clock() - start;
+  if (plan->invalid_city) return -6;
+
+  /* A wrong plan is worse than no plan at all */
+  return plan->cost_overflow ? -1 : 0;
+}
+
+void plan_get_result(Plan plan, struct plan_result *result) {
+  result->connected = plan->n_components <= 1;
+  result->total_plan_cost = plan->total_plan_cost;
+  result->n_ports = plan->n_ports_built;
+  result->n_highways_used = plan->n_highways_used;
+}
+
+int plan_save(Plan plan, Writer w, int sort) {
+  struct plan_header header;
+  struct plan_port port;
+  int i = 0;
+
+  if (sort && !plan->sorted) {
+    if (NULL == plan_scratch(plan) && plan->n_highways > 0) return -1;
+    sort_highways(plan->highways, plan->n_highways, plan->scratch);
+    plan->sorted = 1;
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, PLAN_MAGIC, 4);
+  header.version = PLAN_VERSION;
+#ifdef COST_64
+  header.flags = PLAN_COST_64;
+#endif
+  header.flags |= plan->sorted ? PLAN_SORTED : 0;
+  header.n_cities = plan->n_cities;
+  header.n_highways = plan->n_highways;
+  for (i = 1; i <= plan->n_cities; i++) {
+    header.n_ports += plan->port_costs[i] != 0;
+  }
+  writer_put_bytes(w, &header, sizeof(header));
+
+  /* Padding bytes of the ports are zeroed so that the output is reproducible */
+  memset(&port, 0, sizeof(port));
+  for (i = 1; i <= plan->n_cities; i++) {
+    if (plan->port_costs[i] == 0) continue;
+    port.city = i;
+    port.cost = plan->port_costs[i];
+    writer_put_bytes(w, &port, sizeof(port));
+  }
+
+  writer_put_bytes(w, plan->highways, plan->n_highways * sizeof(struct highway));
+  return w->failed ? -1 : 0;
+}
+
+void plan_get_stats(Plan plan, struct plan_stats *stats) {
+  *stats = plan->stats;
+  stats->finds += plan->dsu.finds;
+  stats->path_length += plan->dsu.path_length;
+  stats->unions += plan->dsu.unions;
+}
+
+void plan_write(Plan plan, Writer w) {
+  int i = 0, n_picks = plan->n_highways_used;
+
+  /* Nothing changed and so, it has finished without connecting all cities */
+  if (plan->n_components > 1) {
+    writer_put_str(w, "Impossible\n");
+    return;
+  }
+
+  /* Algorithm finished and all cities are connected */
+  writer_put_int(w, plan->total_plan_cost);
+  writer_put_char(w, '\n');
+  writer_put_int(w, plan->n_ports_built);
+  writer_put_char(w, ' ');
+  writer_put_int(w, plan->n_highways_used);
+  writer_put_char(w, '\n');
+
+  if (plan->options.output != OUTPUT_FULL) return;
+
+  /* Optimal ports are picked along with the highways, as highways from city 0 */
+  if (plan->options.ports == PORTS_OPTIMAL) {
+    n_picks += plan->n_ports_built;
+    for (i = 0; i < n_picks; i++) {
+      if (plan->picks[i].city_1 != 0) continue;
+      writer_put_str(w, "P ");
+      writer_put_int(w, plan->picks[i].city_2);
+      writer_put_char(w, ' ');
+      writer_put_int(w, plan->picks[i].cost);
+      writer_put_char(w, '\n');
+    }
+  } else {
+    for (i = 1; i <= plan->n_cities; i++) {
+      if (plan->port_costs[i] == 0) continue;
+      writer_put_str(w, "P ");
+      writer_put_int(w, i);
+      writer_put_char(w, ' ');
+      writer_put_int(w, plan->port_costs[i]);
+      writer_put_char(w, '\n');
+    }
+  }
+
+  for (i = 0; i < n_picks; i++) {
+    if (plan->picks[i].city_1 == 0) continue;
+    writer_put_str(w, "H ");
+    writer_put_int(w, plan->picks[i].city_1);
+    writer_put_char(w, ' ');
+    writer_put_int(w, plan->picks[i].city_2);
+    writer_put_char(w, ' ');
+    writer_put_int(w, plan->picks[i].cost);
+    writer_put_char(w, '\n');
+  }
+}
+
+void plan_print(Plan plan, FILE *out) {
+  struct writer w;
+
+  writer_init_memory(&w);
+  plan_write(plan, &w);
+  fwrite(w.buffer, 1, w.size, out);
+  writer_close(&w);
+}
+
+void plan_destroy(Plan plan) {
+  if (NULL == plan) return;
+
+  plan_free_network(plan);
+  if (plan->owns_pool) pool_destroy(plan->pool);
+  free(plan);
+}
@@ -0,0 +1,456 @@
+#ifndef PLAN_H
+#define PLAN_H
+
+#include "dsu.h"
+#include "navyplan.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Below this number of highways Filter-Kruskal filters them serially, even
+ * when the plan has threads.
+ */
+#define PARALLEL_FILTER_THRESHOLD (1 << 16)
+
+/**
+ * @brief Planning context, private to the library.
+ *
+ * @param options configuration of the plan
+ * @param n_cities number of cities in the graph
+ * @param n_ports number of possible ports in the graph
+ * @param n_highways number of possible highways in the graph
+ * @param port_costs cost of building a port in every city (0 if no port can be built)
+ * @param highways highways that can be built, either highways_buffer or, for binary
+ * plans, the highways of the input itself. The kruskal engine may pack them in place
+ * into narrow highways when solving
+ * @param sorted 1 if highways are declared sorted by increasing cost
+ * @param binary 1 if the plan was loaded from the binary format
+ * @param pending input positioned at the highways of a sorted or streamed plan,
+ * which are read by plan_solve() as they are planned (NULL if they were loaded)
+ * @param n_streamed number of highways left in the input for the stream and
+ * external engines, which may not fit in an int
+ * @param invalid_city set to 1 when a highway leads to a city out of the plan, the
+ * highways read while solving ending before it
+ * @param dsu MST sub-tree every city belongs to
+ * @param first_city_with_port first city with a port (0 if none), used to connect
+ * every port
+ * @param total_plan_cost total cost that has to be paid for the plan
+ * @param cost_overflow set to 1 when a cost did not fit in its type (only checked
+ * when built with -D COST_CHECKED)
+ * @param n_components number of city components that are not yet connected
+ * @param n_highways_used number of highways built
+ * @param n_ports_built number of ports built
+ * @param pool worker threads of the parallel engines
+ * @param owns_pool 1 if the pool was started by this plan
+ * @param cities_capacity number of cities port_costs has room for
+ * @param highways_buffer highways read from text plans
+ * @param highways_capacity number of highways highways_buffer has room for
+ * @param scratch sort buffer (NULL until a sort needs it)
+ * @param scratch_capacity number of highways scratch has room for
+ * @param keys packed sort keys followed by their sort buffer (NULL until a key sort
+ * needs them)
+ * @param keys_capacity number of highways keys has room for
+ * @param picks highways built, in pick order (NULL unless the full output is used).
+ * With optimal ports it also holds the ports built, as highways from city 0
+ * @param picks_capacity number of highways picks has room for
+ * @param stats timings and counters of the last plan, the counters of dsu being
+ * added to them when they are read
+ */
+struct plan {
+  struct plan_options options;
+  int n_cities;
+  int n_ports;
+  int n_highways;
+  cost_t *port_costs;
+  Highway highways;
+  int sorted;
+  int binary;
+  Input pending;
+  int64_t n_streamed;
+  int invalid_city;
+  struct dsu dsu;
+  int first_city_with_port;
+  plan_cost_t total_plan_cost;
+  int cost_overflow;
+  int n_components;
+  int n_highways_used;
+  int n_ports_built;
+  Pool pool;
+  int owns_pool;
+  int cities_capacity;
+  Highway highways_buffer;
+  int highways_capacity;
+  Highway scratch;
+  int scratch_capacity;
+  uint64_t *keys;
+  int keys_capacity;
+  Highway picks;
+  int picks_capacity;
+  struct plan_stats stats;
+};
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Scans the cost of a highway or port. When built with -D COST_CHECKED,
+ * costs that do not fit in cost_t are recorded as an overflow.
+ *
+ * @param in input holding the plan in its text format
+ * @param cost where the cost is stored
+ * @param overflow flag set to 1 when the cost overflows
+ *
+ * @return int 1 if a cost was read or 0 if the input has ended
+ */
+static inline int scan_cost(Input in, cost_t *cost, int *overflow) {
+#if defined(COST_64) || defined(COST_CHECKED)
+  int64_t value = 0;
+  if (!input_next_int64(in, &value)) return 0;
+#ifdef COST_CHECKED
+  *overflow |= in->overflow || value < COST_MIN || value > COST_MAX;
+#else
+  (void) overflow;
+#endif
+#else
+  int value = 0;
+  (void) overflow;
+  if (!input_next_int(in, &value)) return 0;
+#endif
+  *cost = (cost_t) value;
+  return 1;
+}
+
+/**
+ * @brief Scans the next highway of a text plan.
+ *
+ * @param in input positioned at a highway of the plan in its text format
+ * @param h where the highway is stored
+ * @param overflow flag set to 1 when the cost overflows
+ *
+ * @return int 1 if a highway was read or 0 if the input has ended
+ */
+static inline int scan_highway(Input in, Highway h, int *overflow) {
+  int city_1 = 0, city_2 = 0;
+  cost_t cost = 0;
+
+  if (!input_next_int(in, &city_1) || !input_next_int(in, &city_2) || !scan_cost(in, &cost, overflow)) return 0;
+  h->city_1 = city_1;
+  h->city_2 = city_2;
+  h->cost = cost;
+  return 1;
+}
+
+/**
+ * @brief SIMD level of the highway scanner.
+ */
+enum scan_simd {
+  SCAN_SCALAR,
+  SCAN_SSE2,
+  SCAN_AVX2
+};
+
+/**
+ * @brief Picks the best SIMD level the processor supports (from CPUID), which the
+ * NAVY_SCAN environment variable can cap to scalar or sse2.
+ *
+ * @return enum scan_simd level to scan with
+ */
+enum scan_simd scan_best_simd(void);
+
+/**
+ * @brief Scans highways of a text plan with the given SIMD level. Blocks of 64 bytes
+ * are classified at once into masks of digits and minus signs, and every number
+ * of the block of at most 8 digits is converted without a branch per digit. The
+ * rest (signed or longer numbers, the end of the input) goes through
+ * scan_highway(), so the highways are the same at every level.
+ *
+ * @param in input positioned at a highway of the plan in its text format
+ * @param hs where the highways are stored
+ * @param n most highways to scan
+ * @param overflow flag set to 1 when a cost overflows
+ * @param simd level to scan with, which the processor must support
+ *
+ * @return int number of highways scanned, fewer than n if the input has ended
+ */
+int scan_highways_simd(Input in, Highway hs, int n, int *overflow, enum scan_simd simd);
+
+/**
+ * @brief Scans highways of a text plan with the best SIMD level, which is resolved
+ * by the first call and kept for the whole process, see scan_highways_simd().
+ *
+ * @param in input positioned at a highway of the plan in its text format
+ * @param hs where the highways are stored
+ * @param n most highways to scan
+ * @param overflow flag set to 1 when a cost overflows
+ *
+ * @return int number of highways scanned, fewer than n if the input has ended
+ */
+int scan_highways(Input in, Highway hs, int n, int *overflow);
+
+/**
+ * @brief Reads the cost of a highway or port, see scan_cost().
+ *
+ * @param plan plan being loaded, whose overflow flag is set
+ * @param in input holding the plan in its text format
+ * @param cost where the cost is stored
+ *
+ * @return int 1 if a cost was read or 0 if the input has ended
+ */
+static inline int read_cost(Plan plan, Input in, cost_t *cost) {
+  return scan_cost(in, cost, &plan->cost_overflow);
+}
+
+/**
+ * @brief Reads the next highway of a text plan, see scan_highway().
+ *
+ * @param plan plan being loaded, whose overflow flag is set
+ * @param in input positioned at a highway of the plan in its text format
+ * @param h where the highway is stored
+ *
+ * @return int 1 if a highway was read or 0 if the input has ended
+ */
+static inline int read_highway(Plan plan, Input in, Highway h) {
+  return scan_highway(in, h, &plan->cost_overflow);
+}
+
+/**
+ * @brief Adds a cost to the total cost of the plan. When built with -D COST_CHECKED
+ * an overflow is recorded instead of wrapping around.
+ *
+ * @param plan plan being solved
+ * @param cost cost of a highway or port that is going to be built
+ */
+static inline void add_plan_cost(Plan plan, cost_t cost) {
+#ifdef COST_CHECKED
+  plan->cost_overflow |= __builtin_add_overflow(plan->total_plan_cost, cost, &plan->total_plan_cost);
+#else
+  plan->total_plan_cost += cost;
+#endif
+}
+
+/**
+ * @brief Builds a highway, adding its cost to the plan and merging the components of
+ * its cities, given as their capitals.
+ *
+ * @param plan plan being solved
+ * @param v1 capital of one of the cities
+ * @param v2 capital of the other city
+ * @param h highway being built
+ */
+static inline void build_highway(Plan plan, int v1, int v2, Highway h) {
+  if (NULL != plan->picks) plan->picks[plan->n_highways_used] = *h;
+  add_plan_cost(plan, h->cost);
+  plan->n_highways_used++;
+  plan->n_components--;
+  dsu_link(&plan->dsu, v1, v2);
+}
+
+/**
+ * @brief Reads a monotonic clock, used to time the phases of a plan.
+ *
+ * @return double seconds since an arbitrary point in the past
+ */
+double plan_clock(void);
+
+/**
+ * @brief Counts the highways at the start of an array that only lead to cities of
+ * the plan, from 1 to n_cities, so that no plan can index the disjoint set out of
+ * bounds.
+ *
+ * @param hs highways to check
+ * @param n number of highways in hs
+ * @param n_cities number of cities of the plan
+ *
+ * @return int number of highways before the first one leading out of the plan, n
+ * if there is none
+ */
+int highways_in_cities(const struct highway *hs, int n, int n_cities);
+
+/**
+ * @brief Gets the sort buffer of a plan, allocating it the first time it is needed
+ * and keeping it for the next plans loaded into the same context.
+ *
+ * @param plan plan being solved
+ *
+ * @return Highway buffer with room for every highway of the plan or NULL if it
+ * could not be allocated
+ */
+Highway plan_scratch(Plan plan);
+
+/**
+ * @brief Gets the key buffer of a plan, allocating it the first time it is needed
+ * and keeping it for the next plans loaded into the same context.
+ *
+ * @param plan plan being solved
+ *
+ * @return uint64_t* buffer with room for two keys per highway of the plan, the keys
+ * and their sort buffer, or NULL if it could not be allocated
+ */
+uint64_t *plan_keys(Plan plan);
+
+/**
+ * @brief Gets the worker threads of a plan, which are the shared pool of its options
+ * or else a pool the plan starts the first time it needs one.
+ *
+ * @param plan plan being loaded or solved
+ *
+ * @return Pool threads of the plan or NULL if they could not be started
+ */
+Pool plan_pool(Plan plan);
+
+/**
+ * @brief Reads the highways of a text plan held whole in memory on every thread of
+ * a pool. The rest of the input is split at line starts into one chunk per thread
+ * and, once the numbers of each chunk have been counted, every thread parses the
+ * highways that start in its chunk straight into its slice of the highways.
+ *
+ * @param plan plan being loaded, with room for n_highways highways
+ * @param in whole input positioned at the highways, left after the last one read
+ * @param pool threads to parse on
+ *
+ * @return int number of highways read, fewer than n_highways if the input ends
+ * before them, or -1 if the chunks could not be allocated and nothing was read
+ */
+int parse_highways_parallel(Plan plan, Input in, Pool pool);
+
+/**
+ * @brief Reads the next chunk of highways of a streamed plan.
+ *
+ * @param plan plan being solved
+ * @param in input positioned at the highways of the plan, in the format the plan
+ * was loaded from
+ * @param chunk where the highways are stored
+ * @param n number of highways to read
+ *
+ * @return int number of highways read, fewer than n if the input has ended or a
+ * highway leads out of the plan (which sets invalid_city)
+ */
+int stream_highways(Plan plan, Input in, Highway chunk, int n);
+
+/**
+ * @brief Moves the input past the next plan without loading it.
+ *
+ * @param in input holding the plan in its text format
+ *
+ * @return int 0 for success or -1 if the input holds no plan
+ */
+int plan_skip(Input in);
+
+
+/* ################################ Engines ################################ */
+
+
+/**
+ * @brief Implementation of the kruskal algorithm to compute a minimum
+ * spanning tree. Source:
+ * https://www.geeksforgeeks.org/kruskals-minimum-spanning-tree-algorithm-greedy-algo-2/
+ *
+ * @param plan plan being solved
+ * @param hs highways sorted by increasing cost
+ * @param n number of highways in hs
+ */
+void kruskal(Plan plan, Highway hs, int n);
+
+/**
+ * @brief Kruskal over narrow highways, see kruskal().
+ *
+ * @param plan plan being solved
+ * @param hs narrow highways sorted by increasing cost
+ * @param n number of highways in hs
+ */
+void kruskal_narrow(Plan plan, NarrowHighway hs, int n);
+
+/**
+ * @brief Kruskal over highways sorted as packed keys, see kruskal(). Each highway
+ * is gathered through the index in its key.
+ *
+ * @param plan plan being solved
+ * @param hs unsorted highways
+ * @param keys keys of hs sorted by sort_highway_keys()
+ * @param n number of highways in hs
+ */
+void kruskal_keys(Plan plan, Highway hs, const uint64_t *keys, int n);
+
+/**
+ * @brief Kruskal over the highways of a sorted text plan, planning each one as soon
+ * as it is read. Reading goes on until every highway is stored, checking that they
+ * are sorted: once one comes out of order, planning stops and the plan has to be
+ * started over from the stored highways.
+ *
+ * @param plan plan being solved
+ * @param in input positioned at the highways of the plan
+ *
+ * @return int 0 if the highways were sorted and the plan is solved, or stopped at
+ * a highway out of the plan (which sets invalid_city), or -1 if they were not sorted
+ */
+int kruskal_parse(Plan plan, Input in);
+
+/**
+ * @brief Kruskal over highways streamed from the input in cost order, in chunks
+ * that are planned and then dropped, so that only the disjoint set is held in
+ * memory. Reading stops as soon as every city is connected.
+ *
+ * @param plan plan being solved
+ * @param in input positioned at the highways of the plan, in the text or binary
+ * format the plan was loaded from
+ *
+ * @return int 0 for success or -1 if a highway was out of order
+ */
+int kruskal_stream(Plan plan, Input in);
+
+/**
+ * @brief Kruskal over highways that do not fit in memory. They are streamed from
+ * the input in runs that fit in options.memory, each run being sorted and written
+ * to a temporary file, and the runs are then merged into a single stream in cost
+ * order that is planned until every city is connected. Inputs that fit in a single
+ * run are planned in memory.
+ *
+ * @param plan plan being solved
+ * @param in input positioned at the highways of the plan
+ *
+ * @return int 0 for success or -1 if the temporary file could not be written or
+ * read, or the runs could not be allocated
+ */
+int kruskal_external(Plan plan, Input in);
+
+/**
+ * @brief Filter-Kruskal. Splits the highways around a pivot cost, plans the light
+ * ones first and filters out of the heavy ones those that became useless before
+ * recursing on them, so that only highways that can still be built get sorted.
+ *
+ * @param plan plan being solved
+ * @param hs unsorted highways
+ * @param n number of highways in hs
+ * @param pool threads to run filter steps of at least PARALLEL_FILTER_THRESHOLD
+ * highways on (NULL to filter serially)
+ */
+void filter_kruskal(Plan plan, Highway hs, int n, Pool pool);
+
+/**
+ * @brief Boruvka algorithm to compute a minimum spanning tree. Each round finds the
+ * cheapest highway leaving every component in parallel and then builds them,
+ * merging components until one is left or no highway leaves them.
+ *
+ * @param plan plan being solved, whose pool is started
+ *
+ * @return int 0 for success or -1 if the rounds could not be allocated
+ */
+int boruvka(Plan plan);
+
+/**
+ * @brief Kruskal over the ports and the highways, where ports are highways from a
+ * virtual sea city 0. A single pass over the sorted highways plans both the network
+ * with the sea and the one with highways only, keeping the cheapest of the two
+ * that connects every city.
+ *
+ * @param plan plan being solved
+ *
+ * @return int 0 for success or -1 if the ports or the disjoint set of the plan
+ * with highways only could not be allocated
+ */
+int kruskal_optimal_ports(Plan plan);
+
+#endif
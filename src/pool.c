@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdlib.h"
+#include "pthread.h"
+#include "unistd.h"
+
+#include "pool.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Pool of worker threads.
+ * 
+ * @param n_threads number of threads, including the caller of pool_run
+ * @param workers worker threads (n_threads - 1 of them)
+ * @param run held by pool_run for a whole task, so that the tasks of callers
+ * sharing the pool run one after the other
+ * @param lock protects every field below it
+ * @param start signalled when a new task is published
+ * @param done signalled when the last worker finishes a task
+ * @param generation incremented for every published task
+ * @param pending number of workers still running the current task
+ * @param stop 1 when the workers should exit
+ * @param task task being run
+ * @param arg argument of the task being run
+ */
+struct pool {
+  int n_threads;
+  pthread_t *workers;
+  pthread_mutex_t run;
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long generation;
+  int pending;
+  int stop;
+  Task task;
+  void *arg;
+};
+
+/**
+ * @brief Arguments of a worker thread.
+ * 
+ * @param pool pool the worker belongs to
+ * @param thread index of the worker in the pool
+ */
+struct worker {
+  Pool pool;
+  int thread;
+};
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Loop of a worker thread. Waits for tasks and runs them until the pool is
+ * destroyed.
+ * 
+ * @param arg struct worker of this thread
+ * 
+ * @return void* always NULL
+ */
+static void *pool_worker(void *arg) {
+  struct worker self = *(struct worker *) arg;
+  Pool pool = self.pool;
+  unsigned long seen = 0;
+
+  free(arg);
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (pool->generation == seen && !pool->stop) {
+      pthread_cond_wait(&pool->start, &pool->lock);
+    }
+    if (pool->stop) break;
+    seen = pool->generation;
+
+    pthread_mutex_unlock(&pool->lock);
+    pool->task(pool->arg, self.thread, pool->n_threads);
+    pthread_mutex_lock(&pool->lock);
+
+    if (--pool->pending == 0) {
+      pthread_cond_signal(&pool->done);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+int pool_default_size(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int) n : 1;
+}
+
+Pool pool_create(int n_threads) {
+  Pool pool = calloc(1, sizeof(struct pool));
+  struct worker *w;
+  int i;
+
+  if (NULL == pool) return NULL;
+  if (n_threads < 1) n_threads = 1;
+
+  pool->n_threads = n_threads;
+  pool->workers = calloc((size_t) n_threads, sizeof(pthread_t));
+  if (NULL == pool->workers) {
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->run, NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  for (i = 1; i < n_threads; i++) {
+    w = malloc(sizeof(struct worker));
+    if (NULL == w) break;
+    w->pool = pool;
+    w->thread = i;
+    if (pthread_create(&pool->workers[i], NULL, pool_worker, w) != 0) {
+      free(w);
+      break;
+    }
+  }
+
+  /* Runs with the threads that could be started */
+  pool->n_threads = i;
+  return pool;
+}
+
+int pool_size(Pool pool) {
+  return pool->n_threads;
+}
+
+void pool_run(Pool pool, Task task, void *arg) {
+  if (pool->n_threads == 1) {
+    task(arg, 0, 1);
+    return;
+  }
+
+  /* A single task is published at a time, other callers queue for the pool */
+  pthread_mutex_lock(&pool->run);
+  pthread_mutex_lock(&pool->lock);
+  pool->task = task;
+  pool->arg = arg;
+  pool->pending = pool->n_threads - 1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  task(arg, 0, pool->n_threads);
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->pending > 0) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  pthread_mutex_unlock(&pool->run);
+}
+
+void pool_destroy(Pool pool) {
+  int i;
+
+  if (NULL == pool) return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (i = 1; i < pool->n_threads; i++) {
+    pthread_join(pool->workers[i], NULL);
+  }
+
+  pthread_mutex_destroy(&pool->run);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+  free(pool->workers);
+  free(pool);
+}
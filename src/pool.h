@@ -0,0 +1,63 @@
+#ifndef POOL_H
+#define POOL_H
+
+
+/**
+ * @brief Task run by every thread of a pool.
+ * 
+ * @param arg argument shared by all threads
+ * @param thread index of the running thread, from 0 to n_threads - 1
+ * @param n_threads number of threads running the task
+ */
+typedef void (*Task)(void *arg, int thread, int n_threads);
+
+/**
+ * @brief Fixed set of worker threads that run the same task in fork-join fashion.
+ * The thread calling pool_run takes part in the task as thread 0.
+ */
+typedef struct pool *Pool;
+
+/**
+ * @brief Gets the number of online processors.
+ * 
+ * @return int number of processors (at least 1)
+ */
+int pool_default_size(void);
+
+/**
+ * @brief Starts the worker threads of a pool.
+ * 
+ * @param n_threads number of threads, including the caller of pool_run
+ * 
+ * @return Pool created pool or NULL if it could not be created
+ */
+Pool pool_create(int n_threads);
+
+/**
+ * @brief Gets the number of threads of a pool.
+ * 
+ * @param pool pool to query
+ * 
+ * @return int number of threads
+ */
+int pool_size(Pool pool);
+
+/**
+ * @brief Runs a task on every thread of the pool and waits for all of them. Tasks
+ * run by several threads sharing the pool are run one after the other, so a task
+ * must not itself run a task on the same pool.
+ * 
+ * @param pool pool to run the task on
+ * @param task task to run
+ * @param arg argument given to every thread
+ */
+void pool_run(Pool pool, Task task, void *arg);
+
+/**
+ * @brief Stops and joins the worker threads and frees the pool.
+ * 
+ * @param pool pool to destroy
+ */
+void pool_destroy(Pool pool);
+
+#endif
@@ -0,0 +1,175 @@
+#include "stdlib.h"
+#include "string.h"
+
+#include "plan.h"
+#include "sort.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Virtual city standing for the sea. Building a port is modelled as building
+ * a highway between its city and the sea.
+ */
+#define SEA 0
+
+/**
+ * @brief One of the two plans computed side by side while looking for the optimal
+ * set of ports.
+ *
+ * @param dsu MST sub-tree every city belongs to in this plan
+ * @param picks highways and ports built, in pick order (NULL if not recorded)
+ * @param n_picks number of highways and ports built
+ * @param n_ports number of ports built
+ * @param n_components number of components that are not yet connected
+ * @param cost total cost of this plan
+ * @param overflow set to 1 when the total cost overflowed
+ */
+struct sea_plan {
+  Dsu dsu;
+  Highway picks;
+  int n_picks;
+  int n_ports;
+  int n_components;
+  plan_cost_t cost;
+  int overflow;
+};
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Builds a highway or port in one of the plans if it joins two of its
+ * components.
+ *
+ * @param p plan to build it in
+ * @param h highway or port (a highway from the sea) to build
+ */
+static inline void sea_plan_offer(struct sea_plan *p, Highway h) {
+  int v1 = dsu_find(p->dsu, h->city_1);
+  int v2 = dsu_find(p->dsu, h->city_2);
+
+  if (v1 == v2) return;
+
+#ifdef COST_CHECKED
+  p->overflow |= __builtin_add_overflow(p->cost, h->cost, &p->cost);
+#else
+  p->cost += h->cost;
+#endif
+  if (NULL != p->picks) p->picks[p->n_picks] = *h;
+  p->n_picks++;
+  p->n_ports += h->city_1 == SEA;
+  p->n_components--;
+  dsu_link(p->dsu, v1, v2);
+}
+
+/**
+ * @brief Gathers every port as a highway from the sea, sorted by cost.
+ *
+ * @param plan plan being solved
+ * @param n where the number of ports is stored
+ *
+ * @return Highway sorted ports or NULL if they could not be allocated
+ */
+static Highway sorted_ports(Plan plan, int *n) {
+  Highway ports = malloc((plan->n_cities + 1) * sizeof(struct highway));
+  int i = 0;
+
+  *n = 0;
+  if (NULL == ports) return NULL;
+
+  for (i = 1; i <= plan->n_cities; i++) {
+    if (plan->port_costs[i] == 0) continue;
+    ports[*n].city_1 = SEA;
+    ports[*n].city_2 = i;
+    ports[*n].cost = plan->port_costs[i];
+    (*n)++;
+  }
+
+  sort_highways(ports, *n, NULL);
+  return ports;
+}
+
+
+/* ############################# MST Algorithm ############################# */
+
+
+int kruskal_optimal_ports(Plan plan) {
+  struct sea_plan land, sea, *best;
+  struct dsu land_dsu;
+  Highway ports, hs = plan->highways;
+  int n_ports = 0, i = 0, j = 0, n = plan->n_highways;
+  double start = plan_clock(), sorted = 0;
+
+  memset(&land_dsu, 0, sizeof(land_dsu));
+  ports = sorted_ports(plan, &n_ports);
+  if (NULL == ports || dsu_init(&land_dsu, plan->n_cities + 1) != 0) {
+    free(ports);
+    dsu_free(&land_dsu);
+    return -1;
+  }
+
+  /* Only highways, where every city starts off on its own */
+  memset(&land, 0, sizeof(land));
+  land.dsu = &land_dsu;
+  land.n_components = plan->n_cities;
+  land.picks = NULL != plan->picks ? plan->picks + plan->n_cities + 1 : NULL;
+
+  /* Highways and ports, where the sea is one more component to connect */
+  memset(&sea, 0, sizeof(sea));
+  sea.dsu = &plan->dsu;
+  sea.n_components = plan->n_cities + 1;
+  sea.picks = plan->picks;
+
+  sorted = plan_clock();
+  plan->stats.ports_seconds = sorted - start;
+  start = sorted;
+  if (!plan->sorted) sort_highways(hs, n, plan_scratch(plan));
+  sorted = plan_clock();
+  plan->stats.sort_seconds = sorted - start;
+  start = sorted;
+
+  /* A single pass over the sorted highways plans both, merging the ports into the
+   * plan with the sea as their cost is reached */
+  for (i = 0; i < n && (land.n_components > 1 || sea.n_components > 1); i++) {
+    while (sea.n_components > 1 && j < n_ports && ports[j].cost <= hs[i].cost) {
+      sea_plan_offer(&sea, &ports[j++]);
+    }
+    if (land.n_components > 1) sea_plan_offer(&land, &hs[i]);
+    if (sea.n_components > 1) sea_plan_offer(&sea, &hs[i]);
+  }
+  while (sea.n_components > 1 && j < n_ports) {
+    sea_plan_offer(&sea, &ports[j++]);
+  }
+
+  /* The plan with the sea never wins using a single port: dropping it leaves a plan
+   * with only highways that is cheaper */
+  if (sea.n_components > 1 || (land.n_components <= 1 && land.cost <= sea.cost)) {
+    best = &land;
+  } else {
+    best = &sea;
+  }
+
+  /* The full output lists the picks of the winning plan from the front */
+  if (best == &land && NULL != plan->picks) {
+    memmove(plan->picks, land.picks, land.n_picks * sizeof(struct highway));
+  }
+
+  plan->total_plan_cost = best->cost;
+  plan->cost_overflow |= best->overflow;
+  plan->n_ports_built = best->n_ports;
+  plan->n_highways_used = best->n_picks - best->n_ports;
+  plan->n_components = best->n_components;
+
+  plan->stats.edges_scanned += i + j;
+  plan->stats.finds += land_dsu.finds;
+  plan->stats.path_length += land_dsu.path_length;
+  plan->stats.unions += land_dsu.unions;
+  plan->stats.mst_seconds = plan_clock() - start;
+
+  free(ports);
+  dsu_free(&land_dsu);
+  return 0;
+}
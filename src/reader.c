@@ -0,0 +1,225 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdlib.h"
+#include "string.h"
+#include "fcntl.h"
+#include "unistd.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+
+#include "reader.h"
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Initial size of the buffer used when the input can not be mapped.
+ */
+#define INPUT_CHUNK_SIZE (1 << 16)
+
+/**
+ * @brief Size of the buffer of streamed inputs.
+ */
+#define INPUT_STREAM_SIZE (1 << 20)
+
+/**
+ * @brief Reads everything from a file descriptor into a single heap buffer that
+ * doubles in size whenever it gets full.
+ *
+ * @param fd file descriptor to read from
+ * @param in input where the buffer is going to be stored
+ *
+ * @return int 0 for success or -1 for error
+ */
+static int input_slurp(int fd, Input in) {
+  size_t size = 0, capacity = INPUT_CHUNK_SIZE;
+  char *buffer = malloc(capacity), *bigger;
+  ssize_t n;
+
+  if (NULL == buffer) return -1;
+
+  for (;;) {
+    if (size == capacity) {
+      capacity *= 2;
+      bigger = realloc(buffer, capacity);
+      if (NULL == bigger) {
+        free(buffer);
+        return -1;
+      }
+      buffer = bigger;
+    }
+
+    n = read(fd, buffer + size, capacity - size);
+    if (n == 0) break;
+    if (n < 0) {
+      free(buffer);
+      return -1;
+    }
+    size += (size_t) n;
+  }
+
+  in->data = buffer;
+  in->end = buffer + size;
+  in->mapped = 0;
+  return 0;
+}
+
+/**
+ * @brief Maps a regular file into memory so that it can be scanned in place. The
+ * mapping is private and writable, so that binary plans can be reordered in place
+ * without touching the file: only the pages that are written get copied.
+ *
+ * @param fd file descriptor of the file
+ * @param size size of the file in bytes
+ * @param in input where the mapping is going to be stored
+ *
+ * @return int 0 for success or -1 for error
+ */
+static int input_map(int fd, size_t size, Input in) {
+  void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+  if (MAP_FAILED == data) return -1;
+
+  /* The input is scanned from start to end exactly once */
+  posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+
+  in->data = data;
+  in->end = (const char *) data + size;
+  in->mapped = 1;
+  return 0;
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+Input input_open(const char *path) {
+  Input in = calloc(1, sizeof(struct input));
+  struct stat st;
+  int fd = STDIN_FILENO, status = -1;
+
+  if (NULL == in) return NULL;
+
+  if (NULL != path) {
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+      free(in);
+      return NULL;
+    }
+  }
+
+  /* Empty files can not be mapped and so they take the slurp path as pipes do */
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    status = input_map(fd, (size_t) st.st_size, in);
+  }
+  if (status != 0) {
+    status = input_slurp(fd, in);
+  }
+
+  if (NULL != path) close(fd);
+
+  if (status != 0) {
+    free(in);
+    return NULL;
+  }
+
+  in->cursor = in->data;
+  in->fd = -1;
+  in->eof = 1;
+  return in;
+}
+
+Input input_open_stream(const char *path) {
+  Input in = calloc(1, sizeof(struct input));
+  char *buffer = malloc(INPUT_STREAM_SIZE);
+
+  if (NULL == in || NULL == buffer) {
+    free(in);
+    free(buffer);
+    return NULL;
+  }
+
+  in->fd = NULL != path ? open(path, O_RDONLY) : STDIN_FILENO;
+  if (in->fd < 0) {
+    free(in);
+    free(buffer);
+    return NULL;
+  }
+
+  in->data = in->end = in->cursor = buffer;
+  input_refill(in);
+  return in;
+}
+
+long input_refill(Input in) {
+  char *buffer = (char *) in->data;
+  size_t size = (size_t) (in->end - in->cursor);
+  ssize_t n;
+
+  if (in->eof) return (long) size;
+
+  /* Keeps the unscanned bytes and fills the rest of the buffer */
+  memmove(buffer, in->cursor, size);
+  while (size < INPUT_STREAM_SIZE) {
+    n = read(in->fd, buffer + size, INPUT_STREAM_SIZE - size);
+    if (n <= 0) {
+      in->eof = 1;
+      break;
+    }
+    size += (size_t) n;
+  }
+
+  in->cursor = buffer;
+  in->end = buffer + size;
+  return (long) size;
+}
+
+long input_read_bytes(Input in, void *bytes, long n) {
+  char *p = bytes;
+  long copied = 0, chunk = 0;
+
+  while (copied < n) {
+    if (in->cursor == in->end && input_refill(in) == 0) break;
+    chunk = in->end - in->cursor < n - copied ? in->end - in->cursor : n - copied;
+    memcpy(p + copied, in->cursor, (size_t) chunk);
+    in->cursor += chunk;
+    copied += chunk;
+  }
+
+  return copied;
+}
+
+void input_close(Input in) {
+  if (NULL == in) return;
+
+  if (in->fd > STDIN_FILENO) close(in->fd);
+  if (in->mapped) {
+    munmap((void *) in->data, (size_t) (in->end - in->data));
+  } else {
+    free((void *) in->data);
+  }
+  free(in);
+}
+
+long input_skip_ints(Input in, long n) {
+  const char *p = in->cursor, *end = in->end;
+  long skipped = 0;
+
+  for (skipped = 0; skipped < n; skipped++) {
+    while (p < end && (unsigned char) (*p - '0') > 9 && *p != '-') p++;
+    if (end - p < INPUT_NUMBER_MAX && !in->eof) {
+      in->cursor = p;
+      input_refill(in);
+      p = in->cursor;
+      end = in->end;
+      while (p < end && (unsigned char) (*p - '0') > 9 && *p != '-') p++;
+    }
+    if (p == end) break;
+    p++;
+    while (p < end && (unsigned char) (*p - '0') <= 9) p++;
+  }
+
+  in->cursor = p;
+  return skipped;
+}
@@ -0,0 +1,191 @@
+#ifndef READER_H
+#define READER_H
+
+#include "stddef.h"
+#include "stdint.h"
+
+
+/* ################################# Input ################################# */
+
+
+/**
+ * @brief Whole input of the program held in a single contiguous buffer. It is
+ * either a private memory mapping of the input file or, when the input is a pipe, a
+ * heap buffer holding everything that was read from it. Either way, it may be
+ * written to without changing the file.
+ *
+ * @param data first byte of the input
+ * @param end one past the last byte of the input
+ * @param cursor next byte that is going to be scanned
+ * @param mapped 1 if data is a memory mapping and 0 if it lives in the heap
+ * @param overflow set to 1 when a 64-bit integer did not fit in 64 bits
+ * @param fd file descriptor streamed inputs are read from (-1 for whole inputs)
+ * @param eof 1 once everything was read into data, always for whole inputs
+ */
+typedef struct input {
+  const char *data;
+  const char *end;
+  const char *cursor;
+  int mapped;
+  int overflow;
+  int fd;
+  int eof;
+} *Input;
+
+/**
+ * @brief Scanners refill streamed inputs whenever fewer bytes than this are left,
+ * so that a number is never split between two chunks.
+ */
+#define INPUT_NUMBER_MAX 24
+
+/**
+ * @brief Opens the input of the program. Regular files are memory mapped and
+ * anything else (pipes, terminals) is read into a single heap buffer.
+ *
+ * @param path path of the input file or NULL to use the standard input
+ *
+ * @return Input opened input or NULL if it could not be read
+ */
+Input input_open(const char *path);
+
+/**
+ * @brief Opens the input of the program as a stream: it is read in fixed size
+ * chunks as it is scanned, so that inputs larger than memory can be scanned once
+ * from start to end. Only the unscanned part of the current chunk is in data.
+ *
+ * @param path path of the input file or NULL to use the standard input
+ *
+ * @return Input opened input or NULL if it could not be read
+ */
+Input input_open_stream(const char *path);
+
+/**
+ * @brief Reads the next chunk of a streamed input, keeping the bytes that were not
+ * scanned yet at the start of the buffer.
+ *
+ * @param in input to refill
+ *
+ * @return int number of bytes that are now ready to be scanned
+ */
+long input_refill(Input in);
+
+/**
+ * @brief Copies raw bytes out of the input, refilling it as needed.
+ *
+ * @param in input to read from
+ * @param bytes where the bytes are copied
+ * @param n number of bytes to copy
+ *
+ * @return long number of bytes copied, fewer than n if the input has ended
+ */
+long input_read_bytes(Input in, void *bytes, long n);
+
+/**
+ * @brief Unmaps or frees the input buffer and releases the input itself.
+ *
+ * @param in input to close
+ */
+void input_close(Input in);
+
+/**
+ * @brief Skips integers of the input without converting them.
+ *
+ * @param in input to scan
+ * @param n number of integers to skip
+ *
+ * @return long number of integers that were skipped
+ */
+long input_skip_ints(Input in, long n);
+
+/**
+ * @brief Scans the next decimal integer of the input, skipping anything that is
+ * not a digit or a minus sign before it. Kept inline as it is called once per
+ * number of the input.
+ *
+ * @param in input to scan
+ * @param value where the scanned integer is stored
+ *
+ * @return int 1 if an integer was read or 0 if the input has ended
+ */
+static inline int input_next_int(Input in, int *value) {
+  const char *p = in->cursor, *end = in->end;
+  unsigned int r = 0;
+  int negative = 0;
+
+  /* Skips separators until the start of the next number, which must be whole */
+  for (;;) {
+    while (p < end && (unsigned char) (*p - '0') > 9 && *p != '-') p++;
+    if (end - p >= INPUT_NUMBER_MAX || in->eof) break;
+    in->cursor = p;
+    input_refill(in);
+    p = in->cursor;
+    end = in->end;
+  }
+  if (p == end) {
+    in->cursor = p;
+    return 0;
+  }
+
+  if (*p == '-') {
+    negative = 1;
+    p++;
+  }
+
+  /* Accumulates digits, unsigned so that garbage can not trigger overflow UB */
+  while (p < end && (unsigned char) (*p - '0') <= 9) {
+    r = r * 10 + (unsigned int) (*p - '0');
+    p++;
+  }
+
+  in->cursor = p;
+  *value = negative ? -(int) r : (int) r;
+  return 1;
+}
+
+/**
+ * @brief Scans the next decimal integer of the input as a 64-bit integer. Numbers
+ * that do not fit in 64 bits set the overflow flag of the input.
+ *
+ * @param in input to scan
+ * @param value where the scanned integer is stored
+ *
+ * @return int 1 if an integer was read or 0 if the input has ended
+ */
+static inline int input_next_int64(Input in, int64_t *value) {
+  const char *p = in->cursor, *end = in->end;
+  uint64_t r = 0;
+  int negative = 0;
+
+  for (;;) {
+    while (p < end && (unsigned char) (*p - '0') > 9 && *p != '-') p++;
+    if (end - p >= INPUT_NUMBER_MAX || in->eof) break;
+    in->cursor = p;
+    input_refill(in);
+    p = in->cursor;
+    end = in->end;
+  }
+  if (p == end) {
+    in->cursor = p;
+    return 0;
+  }
+
+  if (*p == '-') {
+    negative = 1;
+    p++;
+  }
+
+  while (p < end && (unsigned char) (*p - '0') <= 9) {
+    unsigned int digit = (unsigned int) (*p - '0');
+    if (r > (uint64_t) INT64_MAX / 10 - 1) {
+      in->overflow |= r > ((uint64_t) INT64_MAX - digit) / 10;
+    }
+    r = r * 10 + digit;
+    p++;
+  }
+
+  in->cursor = p;
+  *value = negative ? -(int64_t) r : (int64_t) r;
+  return 1;
+}
+
+#endif
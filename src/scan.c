@@ -0,0 +1,231 @@
+#include "stdlib.h"
+#include "string.h"
+
+#include "plan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include "immintrin.h"
+#define SCAN_X86
+#endif
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Number of bytes classified at once by the vectorized scanner.
+ */
+#define SCAN_BLOCK 64
+
+/**
+ * @brief Blocks are only scanned when this many bytes are left, so that the 8-byte
+ * loads of their last numbers stay inside the input.
+ */
+#define SCAN_MARGIN (SCAN_BLOCK + 8)
+
+/**
+ * @brief Longest number converted by the vectorized scanner, which always fits in a
+ * cost. Longer ones are left to the scalar scanner.
+ */
+#define SCAN_MAX_DIGITS 8
+
+/**
+ * @brief Classifies the bytes of a block.
+ *
+ * @param p first byte of the block
+ * @param minus where the mask of the minus signs of the block is stored
+ *
+ * @return uint64_t mask of the digits of the block, bit i for byte i
+ */
+typedef uint64_t (*DigitMask)(const char *p, uint64_t *minus);
+
+/**
+ * @brief Level scan_highways() scans with, resolved by its first call (-1 until
+ * then). Threads that race to resolve it all store the same level.
+ */
+static int scan_level = -1;
+
+
+/* ################################ Helpers ################################ */
+
+
+#ifdef SCAN_X86
+
+/**
+ * @brief Classifies a block 16 bytes at a time with SSE2.
+ */
+__attribute__((target("sse2")))
+static uint64_t digit_mask_sse2(const char *p, uint64_t *minus) {
+  const __m128i zero = _mm_set1_epi8('0'), ten = _mm_set1_epi8(10), dash = _mm_set1_epi8('-');
+  uint64_t digits = 0, m = 0;
+  int i = 0;
+
+  /* Bytes are digits when their distance to '0' is within [0, 10) as a signed byte */
+  for (i = 0; i < SCAN_BLOCK; i += 16) {
+    __m128i bytes = _mm_loadu_si128((const __m128i *) (p + i));
+    __m128i offset = _mm_sub_epi8(bytes, zero);
+    __m128i digit = _mm_andnot_si128(_mm_cmplt_epi8(offset, _mm_setzero_si128()), _mm_cmplt_epi8(offset, ten));
+    digits |= (uint64_t) (uint16_t) _mm_movemask_epi8(digit) << i;
+    m |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, dash)) << i;
+  }
+
+  *minus = m;
+  return digits;
+}
+
+/**
+ * @brief Classifies a block 32 bytes at a time with AVX2.
+ */
+__attribute__((target("avx2")))
+static uint64_t digit_mask_avx2(const char *p, uint64_t *minus) {
+  const __m256i zero = _mm256_set1_epi8('0'), ten = _mm256_set1_epi8(10), dash = _mm256_set1_epi8('-');
+  uint64_t digits = 0, m = 0;
+  int i = 0;
+
+  for (i = 0; i < SCAN_BLOCK; i += 32) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i *) (p + i));
+    __m256i offset = _mm256_sub_epi8(bytes, zero);
+    __m256i digit = _mm256_andnot_si256(_mm256_cmpgt_epi8(_mm256_setzero_si256(), offset), _mm256_cmpgt_epi8(ten, offset));
+    digits |= (uint64_t) (uint32_t) _mm256_movemask_epi8(digit) << i;
+    m |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, dash)) << i;
+  }
+
+  *minus = m;
+  return digits;
+}
+
+#endif
+
+/**
+ * @brief Gets the classifier of a SIMD level.
+ *
+ * @param simd level to use
+ *
+ * @return DigitMask classifier or NULL for the scalar scanner
+ */
+static DigitMask scan_digit_mask(enum scan_simd simd) {
+#ifdef SCAN_X86
+  if (simd == SCAN_AVX2) return digit_mask_avx2;
+  if (simd == SCAN_SSE2) return digit_mask_sse2;
+#else
+  (void) simd;
+#endif
+  return NULL;
+}
+
+/**
+ * @brief Converts a run of digits without a branch per digit: the digits are moved
+ * to the top of a little-endian word, below zero bytes standing for leading zeros,
+ * and pairs, quads and octets of digits are then combined by three multiplications.
+ *
+ * @param s first digit, with at least 8 bytes readable from it
+ * @param length number of digits, from 1 to SCAN_MAX_DIGITS
+ *
+ * @return uint32_t value of the digits
+ */
+static inline uint32_t scan_digits(const char *s, int length) {
+  uint64_t v = 0;
+
+  memcpy(&v, s, sizeof(v));
+  v = (v << (8 * (8 - length))) & 0x0F0F0F0F0F0F0F0FULL;
+  v = (v * 2561) >> 8;
+  v = ((v & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+  return (uint32_t) (((v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+}
+
+/**
+ * @brief Scans the whole highways of the next block of the input. The scan stops
+ * before a number that is signed, too long or not ended within the block, which
+ * are left to the scalar scanner.
+ *
+ * @param in input with at least SCAN_MARGIN bytes left, positioned after a number
+ * or separator
+ * @param mask classifier of the block
+ * @param hs where the highways are stored
+ * @param n most highways to scan
+ *
+ * @return int number of highways scanned
+ */
+static int scan_block(Input in, DigitMask mask, Highway hs, int n) {
+  const char *p = in->cursor;
+  uint64_t minus = 0, digits = mask(p, &minus);
+  uint64_t starts = digits & ~(digits << 1), ends = ~digits & (digits << 1);
+  uint64_t before_minus = 0 != minus ? (minus & -minus) - 1 : ~(uint64_t) 0;
+  uint32_t values[3];
+  int n_read = 0, k = 0, last_end = 0;
+
+  while (n_read < n) {
+    for (k = 0; k < 3; k++) {
+      int start = 0, end = 0;
+
+      /* Every run of digits ends where the next one of ends is, if within the block */
+      if (0 == (starts & before_minus) || 0 == ends) break;
+      start = __builtin_ctzll(starts);
+      end = __builtin_ctzll(ends);
+      if (end - start > SCAN_MAX_DIGITS) break;
+
+      values[k] = scan_digits(p + start, end - start);
+      starts &= starts - 1;
+      ends &= ends - 1;
+      last_end = end;
+    }
+    if (k < 3) break;
+
+    hs[n_read].city_1 = (int) values[0];
+    hs[n_read].city_2 = (int) values[1];
+    hs[n_read].cost = (cost_t) values[2];
+    n_read++;
+    in->cursor = p + last_end;
+  }
+
+  return n_read;
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+enum scan_simd scan_best_simd(void) {
+  enum scan_simd simd = SCAN_SCALAR;
+  const char *limit = getenv("NAVY_SCAN");
+
+#ifdef SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) simd = SCAN_SSE2;
+  if (__builtin_cpu_supports("avx2")) simd = SCAN_AVX2;
+#endif
+
+  /* NAVY_SCAN=scalar|sse2 caps the level, e.g. to compare them */
+  if (NULL != limit && strcmp(limit, "scalar") == 0) simd = SCAN_SCALAR;
+  if (NULL != limit && strcmp(limit, "sse2") == 0 && simd > SCAN_SSE2) simd = SCAN_SSE2;
+  return simd;
+}
+
+int scan_highways_simd(Input in, Highway hs, int n, int *overflow, enum scan_simd simd) {
+  DigitMask mask = scan_digit_mask(simd);
+  int i = 0, n_block = 0;
+
+  while (i < n) {
+    if (NULL != mask && in->end - in->cursor >= SCAN_MARGIN && (n_block = scan_block(in, mask, hs + i, n - i)) > 0) {
+      i += n_block;
+      continue;
+    }
+
+    /* Whatever the block could not take is one highway for the scalar scanner */
+    if (!scan_highway(in, &hs[i], overflow)) break;
+    i++;
+  }
+
+  return i;
+}
+
+int scan_highways(Input in, Highway hs, int n, int *overflow) {
+  int simd = __atomic_load_n(&scan_level, __ATOMIC_RELAXED);
+
+  /* CPUID and the environment are only read once, not for every chunk */
+  if (simd < 0) {
+    simd = (int) scan_best_simd();
+    __atomic_store_n(&scan_level, simd, __ATOMIC_RELAXED);
+  }
+  return scan_highways_simd(in, hs, n, overflow, (enum scan_simd) simd);
+}
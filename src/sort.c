@@ -0,0 +1,404 @@
+#include "stdlib.h"
+#include "stdint.h"
+#include "string.h"
+
+#include "sort.h"
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Unsigned integer as wide as the cost, used as the radix sort key.
+ */
+#ifdef COST_64
+typedef uint64_t radix_key_t;
+#else
+typedef uint32_t radix_key_t;
+#endif
+
+/**
+ * @brief Maps a cost to an unsigned key of the given type with the same order,
+ * flipping the sign bit so that negative costs come before positive ones.
+ */
+#define RADIX_KEY(key_t, cost) ((key_t) (cost) ^ ((key_t) 1 << (sizeof(key_t) * 8 - 1)))
+
+/**
+ * @brief Defines an LSD radix sort over the bytes of the cost of a highway layout,
+ * one pass per byte of key_t. Histograms of every byte are built in a single scan
+ * and passes whose byte is the same for every highway are skipped, so small cost
+ * ranges only take one or two scatters. The sort is stable.
+ * 
+ * @param name name of the static function, taking the highways, a scratch buffer
+ * with room for n of them and n
+ * @param highway_t struct of the layout
+ * @param key_t unsigned integer as wide as the cost of the layout
+ */
+#define DEFINE_RADIX_SORT(name, highway_t, key_t)                                      \
+  static void name(highway_t *highways, highway_t *scratch, int n) {                   \
+    int counts[sizeof(key_t)][256];                                                    \
+    highway_t *from = highways, *to = scratch, *swap;                                  \
+    int i, pass, b, sum;                                                               \
+                                                                                       \
+    memset(counts, 0, sizeof(counts));                                                 \
+    for (i = 0; i < n; i++) {                                                          \
+      key_t key = RADIX_KEY(key_t, highways[i].cost);                                  \
+      for (pass = 0; pass < (int) sizeof(key_t); pass++) {                             \
+        counts[pass][(key >> (pass * 8)) & 0xff]++;                                    \
+      }                                                                                \
+    }                                                                                  \
+                                                                                       \
+    for (pass = 0; pass < (int) sizeof(key_t); pass++) {                               \
+      int *count = counts[pass];                                                       \
+      int shift = pass * 8;                                                            \
+                                                                                       \
+      /* Every highway has the same byte here and so the pass would not move anything */ \
+      if (count[(RADIX_KEY(key_t, from[0].cost) >> shift) & 0xff] == n) continue;      \
+                                                                                       \
+      /* Turns the histogram into the starting offset of each bucket */                \
+      for (b = 0, sum = 0; b < 256; b++) {                                             \
+        int c = count[b];                                                              \
+        count[b] = sum;                                                                \
+        sum += c;                                                                      \
+      }                                                                                \
+                                                                                       \
+      for (i = 0; i < n; i++) {                                                        \
+        to[count[(RADIX_KEY(key_t, from[i].cost) >> shift) & 0xff]++] = from[i];      \
+      }                                                                                \
+                                                                                       \
+      swap = from;                                                                     \
+      from = to;                                                                       \
+      to = swap;                                                                       \
+    }                                                                                  \
+                                                                                       \
+    /* An odd number of passes leaves the sorted highways in the scratch buffer */     \
+    if (from != highways) {                                                            \
+      memcpy(highways, from, (size_t) n * sizeof(highway_t));                          \
+    }                                                                                  \
+  }
+
+int highway_compare(const Highway h1, const Highway h2) {
+  return (h1->cost > h2->cost) - (h1->cost < h2->cost);
+}
+
+/**
+ * @brief Sorts highways with qsort and highway_compare.
+ * 
+ * @param highways highways to sort
+ * @param n number of highways
+ */
+static void sort_highways_qsort(Highway highways, int n) {
+  qsort(highways, n, sizeof(struct highway), (int (*) (const void *, const void *)) &highway_compare);
+}
+
+/**
+ * @brief Pass of a parallel radix sort shared by the threads of the pool. Every
+ * thread owns the same slice of from in every pass.
+ *
+ * @param from highways being sorted
+ * @param to buffer the highways are scattered to
+ * @param n number of highways
+ * @param first_pass first byte of the key that is counted
+ * @param last_pass last byte of the key that is counted
+ * @param pass byte of the key the highways are scattered by
+ * @param n_passes number of bytes of the key
+ * @param counts histogram of every byte of the key for every thread, turned into
+ * the offsets of the thread in every bucket before scattering
+ */
+struct radix_job {
+  void *from;
+  void *to;
+  int n;
+  int first_pass;
+  int last_pass;
+  int pass;
+  int n_passes;
+  int *counts;
+};
+
+/**
+ * @brief Defines a parallel LSD radix sort for a highway layout, see
+ * DEFINE_RADIX_SORT. Each pass counts the bytes of the slice of every thread, turns
+ * the counts into offsets bucket by bucket and thread by thread, so that the sort
+ * stays stable, and scatters every slice on its own thread.
+ *
+ * @param name name of the static function, taking the highways, a scratch buffer
+ * with room for n of them, n and the pool to sort on
+ * @param highway_t struct of the layout
+ * @param key_t unsigned integer as wide as the cost of the layout
+ * @param serial serial sort of the layout, used when the counts can not be
+ * allocated
+ */
+#define DEFINE_PARALLEL_RADIX_SORT(name, highway_t, key_t, serial)                     \
+  static void name##_count(void *arg, int thread, int n_threads) {                     \
+    struct radix_job *job = arg;                                                       \
+    highway_t *from = job->from;                                                       \
+    int begin = (int) ((long) job->n * thread / n_threads);                            \
+    int end = (int) ((long) job->n * (thread + 1) / n_threads);                        \
+    int *counts = job->counts + (size_t) thread * job->n_passes * 256;                 \
+    int i, pass;                                                                       \
+                                                                                       \
+    for (pass = job->first_pass; pass <= job->last_pass; pass++) {                     \
+      memset(counts + pass * 256, 0, 256 * sizeof(int));                               \
+    }                                                                                  \
+    for (i = begin; i < end; i++) {                                                    \
+      key_t key = RADIX_KEY(key_t, from[i].cost);                                      \
+      for (pass = job->first_pass; pass <= job->last_pass; pass++) {                   \
+        counts[pass * 256 + ((key >> (pass * 8)) & 0xff)]++;                           \
+      }                                                                                \
+    }                                                                                  \
+  }                                                                                    \
+                                                                                       \
+  static void name##_scatter(void *arg, int thread, int n_threads) {                   \
+    struct radix_job *job = arg;                                                       \
+    highway_t *from = job->from, *to = job->to;                                        \
+    int begin = (int) ((long) job->n * thread / n_threads);                            \
+    int end = (int) ((long) job->n * (thread + 1) / n_threads);                        \
+    int *offsets = job->counts + ((size_t) thread * job->n_passes + job->pass) * 256;  \
+    int shift = job->pass * 8, i;                                                      \
+                                                                                       \
+    for (i = begin; i < end; i++) {                                                    \
+      to[offsets[(RADIX_KEY(key_t, from[i].cost) >> shift) & 0xff]++] = from[i];      \
+    }                                                                                  \
+  }                                                                                    \
+                                                                                       \
+  static void name(highway_t *highways, highway_t *scratch, int n, Pool pool) {        \
+    struct radix_job job;                                                              \
+    int n_threads = pool_size(pool), moved = 0, pass, b, t, sum;                       \
+    void *swap;                                                                        \
+                                                                                       \
+    job.from = highways;                                                               \
+    job.to = scratch;                                                                  \
+    job.n = n;                                                                         \
+    job.n_passes = (int) sizeof(key_t);                                                \
+    job.counts = malloc((size_t) n_threads * sizeof(key_t) * 256 * sizeof(int));       \
+    if (NULL == job.counts) {                                                          \
+      serial(highways, scratch, n);                                                    \
+      return;                                                                          \
+    }                                                                                  \
+                                                                                       \
+    /* Every byte is counted at once, and counted again only once highways moved */    \
+    job.first_pass = 0;                                                                \
+    job.last_pass = job.n_passes - 1;                                                  \
+    pool_run(pool, name##_count, &job);                                                \
+                                                                                       \
+    for (pass = 0; pass < job.n_passes; pass++) {                                      \
+      int first = (int) ((RADIX_KEY(key_t, ((highway_t *) job.from)[0].cost) >> (pass * 8)) & 0xff); \
+                                                                                       \
+      if (moved) {                                                                     \
+        job.first_pass = job.last_pass = pass;                                         \
+        pool_run(pool, name##_count, &job);                                            \
+      }                                                                                \
+                                                                                       \
+      /* Every highway has the same byte here and so the pass would not move anything */ \
+      for (t = 0, sum = 0; t < n_threads; t++) {                                       \
+        sum += job.counts[((size_t) t * job.n_passes + pass) * 256 + first];           \
+      }                                                                                \
+      if (sum == n) continue;                                                          \
+                                                                                       \
+      for (b = 0, sum = 0; b < 256; b++) {                                             \
+        for (t = 0; t < n_threads; t++) {                                              \
+          int *count = &job.counts[((size_t) t * job.n_passes + pass) * 256 + b];      \
+          int c = *count;                                                              \
+          *count = sum;                                                                \
+          sum += c;                                                                    \
+        }                                                                              \
+      }                                                                                \
+                                                                                       \
+      job.pass = pass;                                                                 \
+      pool_run(pool, name##_scatter, &job);                                            \
+      swap = job.from;                                                                 \
+      job.from = job.to;                                                               \
+      job.to = swap;                                                                   \
+      moved = 1;                                                                       \
+    }                                                                                  \
+                                                                                       \
+    if (job.from != (void *) highways) {                                               \
+      memcpy(highways, job.from, (size_t) n * sizeof(highway_t));                      \
+    }                                                                                  \
+    free(job.counts);                                                                  \
+  }
+
+/**
+ * @brief Radix sorts highways, see DEFINE_RADIX_SORT.
+ */
+DEFINE_RADIX_SORT(sort_highways_radix, struct highway, radix_key_t)
+
+/**
+ * @brief Radix sorts narrow highways, see DEFINE_RADIX_SORT.
+ */
+DEFINE_RADIX_SORT(sort_narrow_highways_radix, struct narrow_highway, uint32_t)
+
+/**
+ * @brief Radix sorts highways on a pool, see DEFINE_PARALLEL_RADIX_SORT.
+ */
+DEFINE_PARALLEL_RADIX_SORT(sort_highways_radix_parallel, struct highway, radix_key_t, sort_highways_radix)
+
+/**
+ * @brief Radix sorts narrow highways on a pool, see DEFINE_PARALLEL_RADIX_SORT.
+ */
+DEFINE_PARALLEL_RADIX_SORT(sort_narrow_highways_radix_parallel, struct narrow_highway, uint32_t,
+  sort_narrow_highways_radix)
+
+
+/**
+ * @brief Checks whether the costs of highways all fit in 32 bits.
+ * 
+ * @param highways highways to check
+ * @param n number of highways
+ * 
+ * @return int 1 if they fit and 0 if not
+ */
+static int highway_costs_fit_32(const struct highway *highways, int n) {
+  int i = 0;
+
+  /* 32-bit costs always fit, wider ones have to be checked */
+  for (i = 0; sizeof(cost_t) > sizeof(int32_t) && i < n; i++) {
+    if (highways[i].cost < INT32_MIN || highways[i].cost > INT32_MAX) return 0;
+  }
+
+  return 1;
+}
+
+/**
+ * @brief Sorts highways of fewer than RADIX_SORT_THRESHOLD by insertion, which
+ * unlike qsort keeps highways of equal cost in their order.
+ * 
+ * @param highways highways to sort
+ * @param n number of highways
+ */
+static void sort_highways_insertion(Highway highways, int n) {
+  struct highway h;
+  int i = 0, j = 0;
+
+  for (i = 1; i < n; i++) {
+    h = highways[i];
+    for (j = i; j > 0 && highway_compare(&highways[j - 1], &h) > 0; j--) {
+      highways[j] = highways[j - 1];
+    }
+    highways[j] = h;
+  }
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+void sort_highways(Highway highways, int n, Highway scratch) {
+  Highway buffer = scratch;
+
+  if (n < RADIX_SORT_THRESHOLD) {
+    sort_highways_insertion(highways, n);
+    return;
+  }
+
+  if (NULL == buffer) buffer = malloc((size_t) n * sizeof(struct highway));
+  if (NULL == buffer) {
+    sort_highways_qsort(highways, n);
+    return;
+  }
+
+  sort_highways_radix(highways, buffer, n);
+  if (buffer != scratch) free(buffer);
+}
+
+int highways_are_sorted(const struct highway *highways, int n) {
+  int i = 0;
+
+  for (i = 1; i < n; i++) {
+    if (highways[i].cost < highways[i - 1].cost) return 0;
+  }
+
+  return 1;
+}
+
+int highways_fit_narrow(const struct highway *highways, int n, int n_cities) {
+  return n_cities <= NARROW_MAX_CITIES && highway_costs_fit_32(highways, n);
+}
+
+NarrowHighway pack_narrow_highways(Highway highways, int n) {
+  char *bytes = (char *) highways;
+  struct highway h;
+  struct narrow_highway narrow;
+  int i = 0;
+
+  /* Each narrow highway ends before the next wide one starts, so the highways are
+   * packed front to back in place, copied as bytes since the two layouts overlap */
+  for (i = 0; i < n; i++) {
+    memcpy(&h, bytes + i * sizeof(struct highway), sizeof(h));
+    narrow.city_1 = (uint16_t) h.city_1;
+    narrow.city_2 = (uint16_t) h.city_2;
+    narrow.cost = (int32_t) h.cost;
+    memcpy(bytes + i * sizeof(struct narrow_highway), &narrow, sizeof(narrow));
+  }
+
+  return (NarrowHighway) highways;
+}
+
+void sort_narrow_highways(NarrowHighway highways, int n, NarrowHighway scratch) {
+  sort_narrow_highways_radix(highways, scratch, n);
+}
+
+void sort_highways_parallel(Highway highways, int n, Highway scratch, Pool pool) {
+  if (n < PARALLEL_SORT_THRESHOLD || NULL == pool || pool_size(pool) == 1 || NULL == scratch) {
+    sort_highways(highways, n, scratch);
+    return;
+  }
+
+  sort_highways_radix_parallel(highways, scratch, n, pool);
+}
+
+void sort_narrow_highways_parallel(NarrowHighway highways, int n, NarrowHighway scratch, Pool pool) {
+  if (n < PARALLEL_SORT_THRESHOLD || NULL == pool || pool_size(pool) == 1) {
+    sort_narrow_highways(highways, n, scratch);
+    return;
+  }
+
+  sort_narrow_highways_radix_parallel(highways, scratch, n, pool);
+}
+
+int highways_fit_keys(const struct highway *highways, int n) {
+  return highway_costs_fit_32(highways, n);
+}
+
+void sort_highway_keys(const struct highway *highways, int n, uint64_t *keys, uint64_t *scratch) {
+  int counts[4][256];
+  uint64_t *from = keys, *to = scratch, *swap;
+  int i, pass, b, sum;
+
+  /* Keys start in index order, so the stable passes over the cost bytes alone leave
+   * highways of equal cost in index order and the index bytes need no pass */
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < n; i++) {
+    uint32_t key = RADIX_KEY(uint32_t, highways[i].cost);
+    keys[i] = (uint64_t) key << 32 | (uint32_t) i;
+    for (pass = 0; pass < 4; pass++) {
+      counts[pass][(key >> (pass * 8)) & 0xff]++;
+    }
+  }
+
+  for (pass = 0; pass < 4; pass++) {
+    int *count = counts[pass];
+    int shift = 32 + pass * 8;
+
+    if (n == 0 || count[(from[0] >> shift) & 0xff] == n) continue;
+
+    for (b = 0, sum = 0; b < 256; b++) {
+      int c = count[b];
+      count[b] = sum;
+      sum += c;
+    }
+
+    for (i = 0; i < n; i++) {
+      to[count[(from[i] >> shift) & 0xff]++] = from[i];
+    }
+
+    swap = from;
+    from = to;
+    to = swap;
+  }
+
+  if (from != keys) {
+    memcpy(keys, from, (size_t) n * sizeof(uint64_t));
+  }
+}
@@ -0,0 +1,142 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include "highway.h"
+#include "pool.h"
+
+
+/**
+ * @brief Below this number of highways the radix sort histograms cost more than
+ * they save and the comparison sort is used instead.
+ */
+#define RADIX_SORT_THRESHOLD 256
+
+/**
+ * @brief Below this number of highways the parallel sorts sort serially, as
+ * handing the passes to the pool costs more than it saves.
+ */
+#define PARALLEL_SORT_THRESHOLD (1 << 17)
+
+/**
+ * @brief Highways are sorted as packed keys, and gathered through them when they
+ * are planned, only when a struct highway takes at least this many bytes (64-bit
+ * costs). Smaller highways are cheaper to move than to gather at random. Can be set
+ * at build time, e.g. make defines="-D KEY_SORT_MIN_HIGHWAY_SIZE=0".
+ */
+#ifndef KEY_SORT_MIN_HIGHWAY_SIZE
+#define KEY_SORT_MIN_HIGHWAY_SIZE 16
+#endif
+
+/**
+ * @brief Used in qsort to sort all highways.
+ * 
+ * @param h1 highway 1
+ * @param h2 highway 2
+ * 
+ * @return int -1, 0 or 1 if the cost of h1 is less than, equal to or greater than
+ * the cost of h2
+ */
+int highway_compare(const Highway h1, const Highway h2);
+
+/**
+ * @brief Checks in a single pass whether highways are sorted by increasing cost.
+ * 
+ * @param highways highways to check
+ * @param n number of highways
+ * 
+ * @return int 1 if they are sorted and 0 if not
+ */
+int highways_are_sorted(const struct highway *highways, int n);
+
+/**
+ * @brief Sorts highways by increasing cost. Uses a byte-wise LSD radix sort on the
+ * cost and an insertion sort for tiny inputs, both keeping highways of equal cost
+ * in their order, and falls back to qsort if the scratch buffer can not be
+ * allocated.
+ * 
+ * @param highways highways to sort
+ * @param n number of highways
+ * @param scratch buffer with room for n highways (NULL to allocate one)
+ */
+void sort_highways(Highway highways, int n, Highway scratch);
+
+/**
+ * @brief Checks whether the highways of a plan can be packed into narrow highways
+ * without losing anything.
+ * 
+ * @param highways highways to check
+ * @param n number of highways
+ * @param n_cities number of cities of the plan
+ * 
+ * @return int 1 if every city id fits in 16 bits and every cost in 32 bits and 0
+ * if not
+ */
+int highways_fit_narrow(const struct highway *highways, int n, int n_cities);
+
+/**
+ * @brief Packs highways into narrow highways in place, keeping their order. The
+ * highways can no longer be used as struct highway afterwards.
+ * 
+ * @param highways highways that fit the narrow layout
+ * @param n number of highways
+ * 
+ * @return NarrowHighway the packed highways, at the same address
+ */
+NarrowHighway pack_narrow_highways(Highway highways, int n);
+
+/**
+ * @brief Sorts narrow highways by increasing cost with the LSD radix sort, keeping
+ * highways of equal cost in their order.
+ * 
+ * @param highways highways to sort
+ * @param n number of highways
+ * @param scratch buffer with room for n narrow highways
+ */
+void sort_narrow_highways(NarrowHighway highways, int n, NarrowHighway scratch);
+
+/**
+ * @brief Sorts highways by increasing cost on every thread of a pool, with the same
+ * result as sort_highways(). Each pass of the LSD radix sort is split between the
+ * threads, which count and then scatter their own slice of the highways.
+ * 
+ * @param highways highways to sort
+ * @param n number of highways
+ * @param scratch buffer with room for n highways (NULL to sort serially)
+ * @param pool threads to sort on (NULL to sort serially)
+ */
+void sort_highways_parallel(Highway highways, int n, Highway scratch, Pool pool);
+
+/**
+ * @brief Sorts narrow highways on every thread of a pool, see
+ * sort_highways_parallel().
+ * 
+ * @param highways highways to sort
+ * @param n number of highways
+ * @param scratch buffer with room for n narrow highways
+ * @param pool threads to sort on (NULL to sort serially)
+ */
+void sort_narrow_highways_parallel(NarrowHighway highways, int n, NarrowHighway scratch, Pool pool);
+
+/**
+ * @brief Checks whether highways can be sorted as packed keys.
+ * 
+ * @param highways highways to check
+ * @param n number of highways
+ * 
+ * @return int 1 if every cost fits in 32 bits and 0 if not
+ */
+int highways_fit_keys(const struct highway *highways, int n);
+
+/**
+ * @brief Sorts highways as plain integers without moving them: each one is encoded
+ * as a key holding its cost in the high 32 bits and its index in the low 32 bits,
+ * and the keys are radix sorted. Highways of equal cost end up in index order.
+ * 
+ * @param highways highways whose costs fit in 32 bits
+ * @param n number of highways
+ * @param keys where the sorted keys are written, with room for n keys
+ * @param scratch buffer with room for n keys
+ */
+void sort_highway_keys(const struct highway *highways, int n, uint64_t *keys, uint64_t *scratch);
+
+#endif
@@ -0,0 +1,91 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdlib.h"
+#include "unistd.h"
+
+#include "writer.h"
+
+
+/* ################################# Funcs ################################# */
+
+
+int writer_init_fd(Writer w, int fd) {
+  w->buffer = malloc(WRITER_BUFFER_SIZE);
+  w->size = 0;
+  w->capacity = NULL != w->buffer ? WRITER_BUFFER_SIZE : 0;
+  w->fd = fd;
+  w->failed = NULL == w->buffer;
+  return w->failed ? -1 : 0;
+}
+
+void writer_init_memory(Writer w) {
+  w->buffer = NULL;
+  w->size = w->capacity = 0;
+  w->fd = -1;
+  w->failed = 0;
+}
+
+int writer_flush(Writer w) {
+  size_t done = 0;
+
+  if (w->fd < 0) return w->failed ? -1 : 0;
+
+  while (done < w->size) {
+    ssize_t n = write(w->fd, w->buffer + done, w->size - done);
+    if (n <= 0) {
+      w->failed = 1;
+      break;
+    }
+    done += (size_t) n;
+  }
+
+  w->size = 0;
+  return w->failed ? -1 : 0;
+}
+
+int writer_reserve(Writer w, size_t n) {
+  size_t capacity = w->capacity > 0 ? w->capacity : WRITER_BUFFER_SIZE;
+  char *bigger;
+
+  if (w->size + n <= w->capacity) return 0;
+
+  /* File writers make room by flushing, as long as the bytes fit in the buffer */
+  if (w->fd >= 0 && n <= w->capacity) {
+    writer_flush(w);
+    return w->failed ? -1 : 0;
+  }
+
+  while (capacity < w->size + n) capacity *= 2;
+  bigger = realloc(w->buffer, capacity);
+  if (NULL == bigger) {
+    w->failed = 1;
+    return -1;
+  }
+
+  w->buffer = bigger;
+  w->capacity = capacity;
+  return 0;
+}
+
+void writer_put_bytes(Writer w, const void *bytes, size_t n) {
+  const char *p = bytes;
+
+  while (n > 0) {
+    size_t chunk = w->fd >= 0 && w->capacity > 0 && n > w->capacity ? w->capacity : n;
+
+    if (writer_reserve(w, chunk) != 0) return;
+    memcpy(w->buffer + w->size, p, chunk);
+    w->size += chunk;
+    p += chunk;
+    n -= chunk;
+  }
+}
+
+int writer_close(Writer w) {
+  int status = writer_flush(w);
+
+  free(w->buffer);
+  w->buffer = NULL;
+  w->size = w->capacity = 0;
+  return status;
+}
@@ -0,0 +1,137 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include "stddef.h"
+#include "stdint.h"
+#include "string.h"
+
+
+/* ################################ Writer ################################ */
+
+
+/**
+ * @brief Size of the buffer of a writer backed by a file descriptor.
+ */
+#define WRITER_BUFFER_SIZE (1 << 16)
+
+/**
+ * @brief Buffered output. Either flushed to a file descriptor whenever the buffer is
+ * full or kept in memory, growing as needed, until it is read back.
+ * 
+ * @param buffer bytes written and not yet flushed
+ * @param size number of bytes in the buffer
+ * @param capacity size of the buffer
+ * @param fd file descriptor to flush to (-1 for a memory writer)
+ * @param failed set to 1 when a write or an allocation failed
+ */
+typedef struct writer {
+  char *buffer;
+  size_t size;
+  size_t capacity;
+  int fd;
+  int failed;
+} *Writer;
+
+/**
+ * @brief Initializes a writer flushing to a file descriptor.
+ * 
+ * @param w writer to initialize
+ * @param fd file descriptor to flush to
+ * 
+ * @return int 0 for success or -1 if the buffer could not be allocated
+ */
+int writer_init_fd(Writer w, int fd);
+
+/**
+ * @brief Initializes a writer that keeps everything in memory.
+ * 
+ * @param w writer to initialize
+ */
+void writer_init_memory(Writer w);
+
+/**
+ * @brief Makes room for n more bytes, flushing or growing the buffer.
+ * 
+ * @param w writer
+ * @param n number of bytes that are going to be written
+ * 
+ * @return int 0 for success or -1 if there is no room
+ */
+int writer_reserve(Writer w, size_t n);
+
+/**
+ * @brief Writes the buffer to the file descriptor (no-op for memory writers).
+ * 
+ * @param w writer
+ * 
+ * @return int 0 for success or -1 if a write failed
+ */
+int writer_flush(Writer w);
+
+/**
+ * @brief Flushes and frees the buffer of a writer.
+ * 
+ * @param w writer
+ * 
+ * @return int 0 for success or -1 if a write failed at any point
+ */
+int writer_close(Writer w);
+
+/**
+ * @brief Writes a string.
+ * 
+ * @param w writer
+ * @param s string to write
+ */
+static inline void writer_put_str(Writer w, const char *s) {
+  size_t n = strlen(s);
+  if (writer_reserve(w, n) != 0) return;
+  memcpy(w->buffer + w->size, s, n);
+  w->size += n;
+}
+
+/**
+ * @brief Writes raw bytes, going through the buffer of file writers in chunks so
+ * that it never has to grow.
+ * 
+ * @param w writer
+ * @param bytes bytes to write
+ * @param n number of bytes
+ */
+void writer_put_bytes(Writer w, const void *bytes, size_t n);
+
+/**
+ * @brief Writes a single character.
+ * 
+ * @param w writer
+ * @param c character to write
+ */
+static inline void writer_put_char(Writer w, char c) {
+  if (w->size == w->capacity && writer_reserve(w, 1) != 0) return;
+  w->buffer[w->size++] = c;
+}
+
+/**
+ * @brief Writes an integer in decimal.
+ * 
+ * @param w writer
+ * @param value integer to write
+ */
+static inline void writer_put_int(Writer w, int64_t value) {
+  char digits[20], *p = digits + sizeof(digits);
+  uint64_t v = value < 0 ? -(uint64_t) value : (uint64_t) value;
+  size_t n;
+
+  do {
+    *--p = (char) ('0' + v % 10);
+    v /= 10;
+  } while (v != 0);
+
+  n = (size_t) (digits + sizeof(digits) - p);
+  if (writer_reserve(w, n + 1) != 0) return;
+  if (value < 0) w->buffer[w->size++] = '-';
+  memcpy(w->buffer + w->size, p, n);
+  w->size += n;
+}
+
+#endif
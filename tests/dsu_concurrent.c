@@ -0,0 +1,187 @@
+#include "stdlib.h"
+#include "stdio.h"
+
+#include "src/dsu.h"
+#include "src/pool.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Number of elements of the disjoint sets.
+ */
+#define N_ELEMENTS (1 << 16)
+
+/**
+ * @brief Number of unions of every round, from sparse to dense forests.
+ */
+static const int round_sizes[] = {1 << 10, 1 << 15, 1 << 16, 1 << 18};
+
+/**
+ * @brief Unions shared by the threads of a round.
+ *
+ * @param dsu concurrent disjoint set being linked
+ * @param serial serial disjoint set that went through the same unions
+ * @param pairs elements to merge, two per union, followed by as many to query
+ * @param n number of unions
+ * @param merged number of unions that merged two sets, for every thread
+ * @param failed set when a query saw two elements together that end up apart
+ */
+struct round {
+  Cdsu dsu;
+  Dsu serial;
+  int *pairs;
+  int n;
+  int *merged;
+  int failed;
+};
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Draws the next number of a xorshift generator.
+ *
+ * @param state state of the generator, not 0
+ *
+ * @return unsigned long next number
+ */
+unsigned long next_random(unsigned long *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+/**
+ * @brief Links the unions of the slice of a thread, querying a random pair after
+ * every one. Sets only ever grow, so a pair found together must still be together
+ * in the serial disjoint set.
+ *
+ * @param arg struct round being run
+ * @param thread index of the thread and of its slice
+ * @param n_threads number of threads
+ */
+void union_slice(void *arg, int thread, int n_threads) {
+  struct round *round = arg;
+  int begin = (int) ((long) round->n * thread / n_threads), end = (int) ((long) round->n * (thread + 1) / n_threads);
+  int *queries = round->pairs + 2 * round->n, merged = 0, i = 0;
+  int64_t length = 0;
+
+  for (i = begin; i < end; i++) {
+    int x = queries[2 * i], y = queries[2 * i + 1];
+
+    merged += cdsu_union(round->dsu, round->pairs[2 * i], round->pairs[2 * i + 1]);
+    if (cdsu_same(round->dsu, x, y) && dsu_find_const(round->serial, x, &length) != dsu_find_const(round->serial, y, &length)) {
+      __atomic_store_n(&round->failed, 1, __ATOMIC_RELAXED);
+    }
+  }
+
+  round->merged[thread] = merged;
+}
+
+/**
+ * @brief Checks that the concurrent disjoint set holds the same sets as the serial
+ * one: every serial capital maps to a single concurrent capital and back.
+ *
+ * @param dsu concurrent disjoint set
+ * @param serial serial disjoint set
+ *
+ * @return int 1 if both hold the same sets and 0 if not
+ */
+int same_sets(Cdsu dsu, Dsu serial) {
+  int *capital = malloc(N_ELEMENTS * sizeof(int)), *owner = malloc(N_ELEMENTS * sizeof(int));
+  int x = 0, same = NULL != capital && NULL != owner;
+
+  for (x = 0; same && x < N_ELEMENTS; x++) {
+    capital[x] = owner[x] = -1;
+  }
+  for (x = 0; same && x < N_ELEMENTS; x++) {
+    int s = dsu_find(serial, x), c = cdsu_find(dsu, x);
+
+    if (capital[s] == -1 && owner[c] == -1) {
+      capital[s] = c;
+      owner[c] = s;
+    }
+    same = capital[s] == c && owner[c] == s;
+  }
+
+  free(capital);
+  free(owner);
+  return same;
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+/**
+ * @brief Runs rounds of random unions on a concurrent disjoint set shared by a pool
+ * of threads and on a serial one, then compares them. Meant to run under
+ * ThreadSanitizer (make test_tsan).
+ *
+ * @param argc number of arguments
+ * @param argv optional number of threads (4 by default)
+ *
+ * @return int 0 for success or 1 for error
+ */
+int main(int argc, char *argv[]) {
+  struct cdsu dsu = {0};
+  struct dsu serial = {0};
+  int n_threads = argc > 1 ? atoi(argv[1]) : 4, r = 0;
+  unsigned long state = 88172645463325252UL;
+  Pool pool = n_threads > 0 ? pool_create(n_threads) : NULL;
+
+  if (NULL == pool) {
+    fprintf(stderr, "usage: %s [n_threads]\n", argv[0]);
+    return 1;
+  }
+
+  for (r = 0; r < (int) (sizeof(round_sizes) / sizeof(round_sizes[0])); r++) {
+    struct round round;
+    int n = round_sizes[r], i = 0, merged = 0, serial_merged = 0;
+
+    round.pairs = malloc(4 * (size_t) n * sizeof(int));
+    round.merged = calloc(n_threads, sizeof(int));
+    if (NULL == round.pairs || NULL == round.merged || cdsu_init(&dsu, N_ELEMENTS) || dsu_init(&serial, N_ELEMENTS)) {
+      fprintf(stderr, "dsu_concurrent: out of memory\n");
+      return 1;
+    }
+    for (i = 0; i < 4 * n; i++) {
+      round.pairs[i] = (int) (next_random(&state) % N_ELEMENTS);
+    }
+
+    /* The serial disjoint set is built first, the threads only read it */
+    for (i = 0; i < n; i++) {
+      int x = dsu_find(&serial, round.pairs[2 * i]), y = dsu_find(&serial, round.pairs[2 * i + 1]);
+      if (x != y) {
+        dsu_link(&serial, x, y);
+        serial_merged++;
+      }
+    }
+
+    round.dsu = &dsu;
+    round.serial = &serial;
+    round.n = n;
+    round.failed = 0;
+    pool_run(pool, union_slice, &round);
+
+    for (i = 0; i < n_threads; i++) {
+      merged += round.merged[i];
+    }
+    if (round.failed || merged != serial_merged || !same_sets(&dsu, &serial)) {
+      fprintf(stderr, "dsu_concurrent: round of %d unions differs from the serial disjoint set\n", n);
+      return 1;
+    }
+
+    free(round.pairs);
+    free(round.merged);
+  }
+
+  cdsu_free(&dsu);
+  dsu_free(&serial);
+  pool_destroy(pool);
+  return 0;
+}
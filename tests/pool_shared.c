@@ -0,0 +1,132 @@
+#include "stdlib.h"
+#include "stdio.h"
+#include "pthread.h"
+
+#include "src/navyplan.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Number of threads solving plans at the same time on the shared pool.
+ */
+#define N_SOLVERS 4
+
+/**
+ * @brief Number of plans every solver loads and solves.
+ */
+#define N_ROUNDS 3
+
+/**
+ * @brief Plan every solver loads.
+ */
+const char *path;
+
+/**
+ * @brief Pool shared by every plan.
+ */
+Pool shared;
+
+/**
+ * @brief Outcome of the plan solved on its own, which every solver has to match.
+ */
+struct plan_result expected;
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Loads and solves the plan with options.
+ *
+ * @param options configuration of the plan
+ * @param result where the outcome is stored
+ *
+ * @return int 0 for success or 1 for error
+ */
+int solve(const struct plan_options *options, struct plan_result *result) {
+  Input in = input_open(path);
+  Plan plan = plan_create(options);
+  int status = NULL == in || NULL == plan || plan_load(plan, in) != 0 || plan_solve(plan) != 0;
+
+  if (!status) plan_get_result(plan, result);
+  plan_destroy(plan);
+  if (NULL != in) input_close(in);
+  return status;
+}
+
+/**
+ * @brief Loop of a solver. Goes through every parallel step a plan can take on the
+ * shared pool: the Boruvka rounds, the filter steps, the radix sort and the parser.
+ *
+ * @param arg index of the solver
+ *
+ * @return void* NULL if every plan matched and non-NULL if not
+ */
+void *solver(void *arg) {
+  static const enum engine engines[] = {ENGINE_BORUVKA, ENGINE_FILTER_KRUSKAL, ENGINE_KRUSKAL};
+  long self = (long) arg;
+  int round = 0;
+
+  for (round = 0; round < N_ROUNDS * 3; round++) {
+    struct plan_options options = {0};
+    struct plan_result result;
+
+    options.engine = engines[(self + round) % 3];
+    options.pool = shared;
+    options.parse = round % 2 == 0 ? PARSE_PARALLEL : PARSE_SERIAL;
+    if (solve(&options, &result) != 0 || result.total_plan_cost != expected.total_plan_cost ||
+        result.n_ports != expected.n_ports || result.n_highways_used != expected.n_highways_used) {
+      return arg;
+    }
+  }
+
+  return NULL;
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+/**
+ * @brief Solves a plan from several threads at once, every plan using the same
+ * pool, and checks that they all match the plan solved on a single thread.
+ *
+ * @param argc number of arguments
+ * @param argv plan to solve, big enough for the parallel sort and filter
+ *
+ * @return int 0 for success or 1 for error
+ */
+int main(int argc, char *argv[]) {
+  struct plan_options options = {0};
+  pthread_t solvers[N_SOLVERS];
+  int failed = 0;
+  long i = 0;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s plan\n", argv[0]);
+    return 1;
+  }
+  path = argv[1];
+
+  options.n_threads = 1;
+  shared = pool_create(4);
+  if (NULL == shared || solve(&options, &expected) != 0) {
+    fprintf(stderr, "pool_shared: could not solve %s\n", path);
+    return 1;
+  }
+
+  for (i = 0; i < N_SOLVERS; i++) {
+    if (pthread_create(&solvers[i], NULL, solver, (void *) i) != 0) return 1;
+  }
+  for (i = 0; i < N_SOLVERS; i++) {
+    void *mismatch = NULL;
+    pthread_join(solvers[i], &mismatch);
+    failed |= NULL != mismatch;
+  }
+
+  pool_destroy(shared);
+  if (failed) fprintf(stderr, "pool_shared: a plan solved on the shared pool differs\n");
+  return failed;
+}
@@ -0,0 +1,61 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdlib.h"
+#include "stdio.h"
+#include "string.h"
+#include "unistd.h"
+
+#include "src/navyplan.h"
+
+
+/* ################################# Funcs ################################# */
+
+
+/**
+ * @brief Converts a plan to the binary format, writing it to the standard output.
+ * The plan may be in the text format or already binary, e.g. to sort it.
+ *
+ * @param argc number of arguments
+ * @param argv --sort to sort the highways by cost and optional path of the input
+ * file (standard input is used otherwise)
+ *
+ * @return int 0 for success or 1 for error
+ */
+int main(int argc, char *argv[]) {
+  struct writer out;
+  const char *path = NULL;
+  Input in = NULL;
+  Plan plan = NULL;
+  int i = 0, sort = 0, status = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--sort") == 0) {
+      sort = 1;
+    } else if (argv[i][0] != '-' && NULL == path) {
+      path = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [--sort] [input] > output\n", argv[0]);
+      return 1;
+    }
+  }
+
+  in = input_open(path);
+  if (NULL == in || writer_init_fd(&out, STDOUT_FILENO) != 0) {
+    perror("convert");
+    return 1;
+  }
+
+  plan = plan_create(NULL);
+  if (NULL == plan || plan_load(plan, in) != 0) {
+    fprintf(stderr, "convert: could not load the plan\n");
+    status = 1;
+  } else if (plan_save(plan, &out, sort) != 0) {
+    fprintf(stderr, "convert: could not write the plan\n");
+    status = 1;
+  }
+
+  if (writer_close(&out) != 0) status = 1;
+  plan_destroy(plan);
+  input_close(in);
+  return status;
+}
@@ -0,0 +1,392 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdlib.h"
+#include "stdio.h"
+#include "string.h"
+#include "math.h"
+#include "unistd.h"
+
+#include "src/writer.h"
+
+
+/* ################################ Globals ################################ */
+
+
+/**
+ * @brief Shapes of the generated highway network.
+ */
+enum topology {
+  TOPOLOGY_RANDOM,
+  TOPOLOGY_GRID,
+  TOPOLOGY_GEOMETRIC,
+  TOPOLOGY_POWER_LAW
+};
+
+/**
+ * @brief Distributions the costs of ports and highways are drawn from.
+ */
+enum costs {
+  COSTS_UNIFORM,
+  COSTS_EXPONENTIAL,
+  COSTS_EQUAL
+};
+
+/**
+ * @brief Configuration of the generated plan.
+ *
+ * @param n_cities number of cities
+ * @param n_highways number of highways
+ * @param port_fraction probability of a city having a port
+ * @param max_cost highest cost of a port or highway
+ * @param costs distribution of the costs (geometric networks use distances)
+ * @param topology shape of the highway network
+ * @param seed seed of the random number generator
+ */
+struct gen {
+  int n_cities;
+  long n_highways;
+  double port_fraction;
+  long max_cost;
+  enum costs costs;
+  enum topology topology;
+  unsigned long long seed;
+};
+
+/**
+ * @brief Cities of a geometric network, placed on the unit square and bucketed in
+ * a grid of cells holding about four cities each.
+ *
+ * @param x horizontal coordinate of every city
+ * @param y vertical coordinate of every city
+ * @param cells side of the grid of cells
+ * @param start where the cities of every cell start in by_cell, plus where the last
+ * cell ends
+ * @param by_cell cities sorted by cell
+ */
+struct geometry {
+  double *x;
+  double *y;
+  int cells;
+  int *start;
+  int *by_cell;
+};
+
+/**
+ * @brief State of the xorshift64* random number generator.
+ */
+unsigned long long rng_state;
+
+
+/* ################################ Helpers ################################ */
+
+
+/**
+ * @brief Draws the next 64 random bits.
+ *
+ * @return unsigned long long random bits
+ */
+static inline unsigned long long rng_next(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return rng_state * 2685821657736338717ULL;
+}
+
+/**
+ * @brief Draws a uniform number in [0, 1).
+ *
+ * @return double random number
+ */
+static inline double rng_unit(void) {
+  return (rng_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Draws a uniform integer in [0, n).
+ *
+ * @param n number of values
+ *
+ * @return long random integer
+ */
+static inline long rng_below(long n) {
+  return (long) (rng_unit() * n);
+}
+
+/**
+ * @brief Draws a cost from the configured distribution.
+ *
+ * @param gen configuration
+ *
+ * @return long cost in [1, max_cost]
+ */
+long draw_cost(const struct gen *gen) {
+  double cost = 0;
+
+  switch (gen->costs) {
+    case COSTS_EQUAL:
+      return gen->max_cost;
+    case COSTS_EXPONENTIAL:
+      /* Mean of a tenth of the highest cost, so that cheap highways dominate */
+      cost = 1 - log(1 - rng_unit()) * gen->max_cost / 10;
+      return cost < gen->max_cost ? (long) cost : gen->max_cost;
+    default:
+      return 1 + rng_below(gen->max_cost);
+  }
+}
+
+/**
+ * @brief Places the cities of a geometric network and buckets them by cell.
+ *
+ * @param gen configuration
+ * @param geo where the geometry is stored
+ *
+ * @return int 0 for success or -1 if it could not be allocated
+ */
+int geometry_init(const struct gen *gen, struct geometry *geo) {
+  int n = gen->n_cities, i = 0, c = 0, *fill;
+
+  geo->cells = (int) sqrt(n / 4.0);
+  if (geo->cells < 1) geo->cells = 1;
+  geo->x = malloc((n + 1) * sizeof(double));
+  geo->y = malloc((n + 1) * sizeof(double));
+  geo->start = calloc((size_t) geo->cells * geo->cells + 1, sizeof(int));
+  geo->by_cell = malloc(n * sizeof(int));
+  fill = calloc((size_t) geo->cells * geo->cells, sizeof(int));
+  if (NULL == geo->x || NULL == geo->y || NULL == geo->start || NULL == geo->by_cell || NULL == fill) {
+    free(fill);
+    return -1;
+  }
+
+  /* Counting sort of the cities by cell */
+  for (i = 1; i <= n; i++) {
+    geo->x[i] = rng_unit();
+    geo->y[i] = rng_unit();
+    geo->start[(int) (geo->y[i] * geo->cells) * geo->cells + (int) (geo->x[i] * geo->cells) + 1]++;
+  }
+  for (c = 0; c < geo->cells * geo->cells; c++) {
+    geo->start[c + 1] += geo->start[c];
+  }
+  for (i = 1; i <= n; i++) {
+    c = (int) (geo->y[i] * geo->cells) * geo->cells + (int) (geo->x[i] * geo->cells);
+    geo->by_cell[geo->start[c] + fill[c]++] = i;
+  }
+
+  free(fill);
+  return 0;
+}
+
+/**
+ * @brief Frees the geometry of a geometric network.
+ *
+ * @param geo geometry to free
+ */
+void geometry_free(struct geometry *geo) {
+  free(geo->x);
+  free(geo->y);
+  free(geo->start);
+  free(geo->by_cell);
+}
+
+/**
+ * @brief Picks a city close to another one, from its own cell or a neighbouring one.
+ *
+ * @param geo geometry of the network
+ * @param city city to start from
+ *
+ * @return int nearby city (city itself if no other was found)
+ */
+int geometry_neighbour(const struct geometry *geo, int city) {
+  int cx = (int) (geo->x[city] * geo->cells), cy = (int) (geo->y[city] * geo->cells);
+  int tries = 0, c = 0;
+
+  for (tries = 0; tries < 8; tries++) {
+    int nx = cx + (int) rng_below(3) - 1, ny = cy + (int) rng_below(3) - 1;
+    if (nx < 0 || ny < 0 || nx >= geo->cells || ny >= geo->cells) continue;
+    c = ny * geo->cells + nx;
+    if (geo->start[c + 1] > geo->start[c]) {
+      return geo->by_cell[geo->start[c] + rng_below(geo->start[c + 1] - geo->start[c])];
+    }
+  }
+
+  return city;
+}
+
+/**
+ * @brief Writes the highways of the network.
+ *
+ * @param gen configuration
+ * @param w writer to write to
+ *
+ * @return int 0 for success or -1 if the network could not be allocated
+ */
+int write_highways(const struct gen *gen, Writer w) {
+  struct geometry geo;
+  int n = gen->n_cities, side = (int) ceil(sqrt((double) n)), city_1 = 0, city_2 = 0;
+  long i = 0, cost = 0;
+
+  memset(&geo, 0, sizeof(geo));
+  if (gen->topology == TOPOLOGY_GEOMETRIC && geometry_init(gen, &geo) != 0) {
+    geometry_free(&geo);
+    return -1;
+  }
+
+  for (i = 0; i < gen->n_highways; i++) {
+    switch (gen->topology) {
+      case TOPOLOGY_GRID:
+        /* Joins a cell of a side x side grid to the one on its right or below it */
+        city_1 = (int) rng_below(n);
+        city_2 = rng_below(2) ? city_1 + 1 : city_1 + side;
+        if (city_2 >= n || (city_2 == city_1 + 1 && city_2 % side == 0)) city_2 = city_1 - 1;
+        if (city_2 < 0) city_2 = city_1 + 1 < n ? city_1 + 1 : city_1;
+        city_1++;
+        city_2++;
+        break;
+      case TOPOLOGY_GEOMETRIC:
+        city_1 = 1 + (int) rng_below(n);
+        city_2 = geometry_neighbour(&geo, city_1);
+        break;
+      case TOPOLOGY_POWER_LAW:
+        /* Few hub cities get most of the highways */
+        city_1 = 1 + (int) (n * pow(rng_unit(), 3));
+        city_2 = 1 + (int) rng_below(n);
+        break;
+      default:
+        city_1 = 1 + (int) rng_below(n);
+        city_2 = 1 + (int) rng_below(n);
+    }
+
+    if (gen->topology == TOPOLOGY_GEOMETRIC) {
+      double dx = geo.x[city_1] - geo.x[city_2], dy = geo.y[city_1] - geo.y[city_2];
+      cost = 1 + (long) (sqrt(dx * dx + dy * dy) * geo.cells * gen->max_cost / 3);
+      if (cost > gen->max_cost) cost = gen->max_cost;
+    } else {
+      cost = draw_cost(gen);
+    }
+
+    writer_put_int(w, city_1);
+    writer_put_char(w, ' ');
+    writer_put_int(w, city_2);
+    writer_put_char(w, ' ');
+    writer_put_int(w, cost);
+    writer_put_char(w, '\n');
+  }
+
+  geometry_free(&geo);
+  return 0;
+}
+
+/**
+ * @brief Reads the command line options.
+ *
+ * @param argc number of arguments
+ * @param argv arguments of the program
+ * @param gen where the configuration is stored
+ *
+ * @return int 0 for success or -1 for an invalid option
+ */
+int parse_options(int argc, char *argv[], struct gen *gen) {
+  int i = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--cities=", 9) == 0) {
+      gen->n_cities = atoi(argv[i] + 9);
+    } else if (strncmp(argv[i], "--highways=", 11) == 0) {
+      gen->n_highways = atol(argv[i] + 11);
+    } else if (strncmp(argv[i], "--ports=", 8) == 0) {
+      gen->port_fraction = atof(argv[i] + 8);
+    } else if (strncmp(argv[i], "--max-cost=", 11) == 0) {
+      gen->max_cost = atol(argv[i] + 11);
+    } else if (strcmp(argv[i], "--costs=uniform") == 0) {
+      gen->costs = COSTS_UNIFORM;
+    } else if (strcmp(argv[i], "--costs=exponential") == 0) {
+      gen->costs = COSTS_EXPONENTIAL;
+    } else if (strcmp(argv[i], "--costs=equal") == 0) {
+      gen->costs = COSTS_EQUAL;
+    } else if (strcmp(argv[i], "--topology=random") == 0) {
+      gen->topology = TOPOLOGY_RANDOM;
+    } else if (strcmp(argv[i], "--topology=grid") == 0) {
+      gen->topology = TOPOLOGY_GRID;
+    } else if (strcmp(argv[i], "--topology=geometric") == 0) {
+      gen->topology = TOPOLOGY_GEOMETRIC;
+    } else if (strcmp(argv[i], "--topology=power-law") == 0) {
+      gen->topology = TOPOLOGY_POWER_LAW;
+    } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+      gen->seed = strtoull(argv[i] + 7, NULL, 10);
+    } else {
+      return -1;
+    }
+  }
+
+  return gen->n_cities > 0 && gen->n_highways >= 0 && gen->max_cost > 0 ? 0 : -1;
+}
+
+
+/* ################################# Funcs ################################# */
+
+
+/**
+ * @brief Writes a random plan in the input format of the planner to the standard
+ * output.
+ *
+ * @param argc number of arguments
+ * @param argv options of the generated plan
+ *
+ * @return int 0 for success or 1 for error
+ */
+int main(int argc, char *argv[]) {
+  struct gen gen;
+  struct writer w;
+  int i = 0, n_ports = 0, status = 0;
+  unsigned long long seed = 0;
+
+  memset(&gen, 0, sizeof(gen));
+  gen.n_cities = 1000;
+  gen.n_highways = 4000;
+  gen.port_fraction = 0.01;
+  gen.max_cost = 1000000;
+  gen.seed = 1;
+  if (parse_options(argc, argv, &gen) != 0) {
+    fprintf(stderr, "usage: %s [--cities=N] [--highways=M] [--ports=FRACTION] [--max-cost=C] "
+      "[--costs=uniform|exponential|equal] [--topology=random|grid|geometric|power-law] [--seed=S]\n", argv[0]);
+    return 1;
+  }
+  if (writer_init_fd(&w, STDOUT_FILENO) != 0) {
+    perror("gen");
+    return 1;
+  }
+
+  /* Ports are drawn twice from the same seed: once to count them, once to write them */
+  rng_state = seed = gen.seed * 0x9E3779B97F4A7C15ULL | 1;
+  for (i = 1; i <= gen.n_cities; i++) {
+    if (rng_unit() >= gen.port_fraction) continue;
+    draw_cost(&gen);
+    n_ports++;
+  }
+
+  writer_put_int(&w, gen.n_cities);
+  writer_put_char(&w, '\n');
+  writer_put_int(&w, n_ports);
+  writer_put_char(&w, '\n');
+
+  rng_state = seed;
+  for (i = 1; i <= gen.n_cities; i++) {
+    if (rng_unit() >= gen.port_fraction) continue;
+    writer_put_int(&w, i);
+    writer_put_char(&w, ' ');
+    writer_put_int(&w, draw_cost(&gen));
+    writer_put_char(&w, '\n');
+  }
+
+  writer_put_int(&w, gen.n_highways);
+  writer_put_char(&w, '\n');
+  if (write_highways(&gen, &w) != 0) {
+    fprintf(stderr, "gen: could not allocate the network\n");
+    status = 1;
+  }
+
+  if (writer_close(&w) != 0) {
+    perror("gen");
+    status = 1;
+  }
+  return status;
+}